@@ -743,6 +743,11 @@ struct cl_page {
          * creation.
          */
         enum cl_page_type        cp_type;
+	/**
+	 * Index of the slab cache this page was allocated from, or -1 if
+	 * it was allocated with kmalloc.
+	 */
+	short			 cp_kmem_index;
 
         /**
          * Owning IO in cl_page_state::CPS_OWNED state. Sub-page can be owned
@@ -1814,7 +1819,8 @@ struct cl_io {
 			struct file		*rw_file;
 			unsigned int		 rw_nonblock:1,
 						 rw_append:1,
-						 rw_sync:1;
+						 rw_sync:1,
+						 rw_direct:1;
 			int (*rw_ptask)(struct cfs_ptask *ptask);
 		} ci_rw;
 		struct cl_setattr_io {
@@ -1916,7 +1922,13 @@ struct cl_io {
 	 * mirror is inaccessible, non-delay RPC would error out quickly so
 	 * that the upper layer can try to access the next mirror.
 	 */
-			     ci_ndelay:1;
+			     ci_ndelay:1,
+	/**
+	 * Set if this io is issued by the async readahead worker. Such an
+	 * io only populates pages covered by already granted DLM locks and
+	 * never copies data to a user buffer.
+	 */
+			     ci_async_readahead:1;
 	/**
 	 * How many times the read has retried before this one.
 	 * Set by the top level and consumed by the LOV.
@@ -2377,6 +2389,15 @@ static inline int cl_io_is_sync_write(const struct cl_io *io)
 	return io->ci_type == CIT_WRITE && io->u.ci_rw.rw_sync;
 }
 
+/**
+ * True, iff \a io is an O_DIRECT read(2) or write(2).
+ */
+static inline int cl_io_is_direct(const struct cl_io *io)
+{
+	return (io->ci_type == CIT_READ || io->ci_type == CIT_WRITE) &&
+		io->u.ci_rw.rw_direct;
+}
+
 static inline int cl_io_is_mkwrite(const struct cl_io *io)
 {
 	return io->ci_type == CIT_FAULT && io->u.ci_fault.ft_mkwrite;
@@ -145,6 +145,7 @@ enum {
         LPROCFS_TYPE_BYTES        = 0x0200,
         LPROCFS_TYPE_PAGES        = 0x0400,
         LPROCFS_TYPE_CYCLE        = 0x0800,
+	LPROCFS_TYPE_USEC	  = 0x1000,
 };
 
 #define LC_MIN_INIT ((~(__u64)0) >> 1)
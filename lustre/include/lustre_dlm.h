@@ -44,6 +44,7 @@
 #ifndef _LUSTRE_DLM_H__
 #define _LUSTRE_DLM_H__
 
+#include <libcfs/linux/linux-hash.h>
 #include <lustre_lib.h>
 #include <lustre_net.h>
 #include <lustre_import.h>
@@ -68,6 +69,8 @@ extern struct kset *ldlm_svc_kset;
  * client shows interest in that lock, e.g. glimpse is occured. */
 #define LDLM_DIRTY_AGE_LIMIT (10)
 #define LDLM_DEFAULT_PARALLEL_AST_LIMIT 1024
+/* Maximum number of locks revoked by a single batched blocking AST */
+#define LDLM_BL_BATCH_MAX	32
 
 /**
  * LDLM non-error return states
@@ -321,6 +324,7 @@ enum ldlm_appetite {
 #define NS_DEFAULT_MAX_NOLOCK_BYTES 0
 #define NS_DEFAULT_CONTENTION_SECONDS 2
 #define NS_DEFAULT_CONTENDED_LOCKS 32
+#define NS_DEFAULT_EXPAND_HISTORY 1
 
 struct ldlm_ns_bucket {
 	/** back pointer to namespace */
@@ -337,6 +341,23 @@ struct ldlm_ns_bucket {
 	int			    nsb_reclaim_start;
 };
 
+/**
+ * Part of the namespace LRU list, one per CPU partition. Locks stay in the
+ * part chosen when they were created, see \a l_lru_cpt in struct ldlm_lock,
+ * so that clients enqueueing and releasing locks from different partitions
+ * do not serialize on a single list lock.
+ */
+struct ldlm_ns_lru {
+	/** protects \a nl_list, \a nl_nr_unused and \a nl_last_pos */
+	spinlock_t		 nl_lock;
+	/** unused locks of this part, least recently used first */
+	struct list_head	 nl_list;
+	/** number of locks in \a nl_list */
+	int			 nl_nr_unused;
+	/** position of the last LDLM_LRU_FLAG_NO_WAIT scan in \a nl_list */
+	struct list_head	*nl_last_pos;
+};
+
 enum {
 	/** LDLM namespace lock stats */
 	LDLM_NSS_LOCKS          = 0,
@@ -386,6 +407,12 @@ struct ldlm_namespace {
 
 	/** Resource hash table for namespace. */
 	struct cfs_hash		*ns_rs_hash;
+	/**
+	 * RCU index of the resources in \a ns_rs_hash, used for lockless
+	 * lookups in ldlm_resource_get(). Resources are added and removed
+	 * under the bucket lock of \a ns_rs_hash.
+	 */
+	struct rhashtable	ns_rs_rhash;
 
 	/** serialize */
 	spinlock_t		ns_lock;
@@ -420,11 +447,12 @@ struct ldlm_namespace {
 	 * us to release some locks due to e.g. memory pressure, we take locks
 	 * to release from the head of this list.
 	 * Locks are linked via l_lru field in \see struct ldlm_lock.
+	 * The list is split into per-CPT parts, \see struct ldlm_ns_lru,
+	 * each of them ordered by lock last use time.
 	 */
-	struct list_head	ns_unused_list;
-	/** Number of locks in the LRU list above */
-	int			ns_nr_unused;
-	struct list_head	*ns_last_pos;
+	struct ldlm_ns_lru	**ns_lru;
+	/** Number of locks in all parts of the LRU list above */
+	atomic_t		ns_nr_unused;
 
 	/**
 	 * Maximum number of locks permitted in the LRU. If 0, means locks
@@ -508,6 +536,12 @@ struct ldlm_namespace {
 	 */
 	unsigned		ns_max_nolock_size;
 
+	/**
+	 * Limit extent lock expansion to the region each client has been
+	 * writing recently, instead of growing it up to the nearest conflict.
+	 */
+	unsigned int		ns_expand_history:1;
+
 	/** Limit of parallel AST RPC count. */
 	unsigned		ns_max_parallel_ast;
 
@@ -623,11 +657,14 @@ struct ldlm_cb_set_arg {
 	ptlrpc_interpterer_t		 gl_interpret_reply;
 	void				*gl_interpret_data;
 	struct ldlm_bl_desc		*bl_desc;
+	/* blocking AST batch being filled for one export */
+	struct ldlm_bl_batch		*bl_batch;
 };
 
 struct ldlm_cb_async_args {
 	struct ldlm_cb_set_arg	*ca_set_arg;
 	struct ldlm_lock	*ca_lock;
+	struct ldlm_bl_batch	*ca_batch;
 };
 
 /** The ldlm_glimpse_work was slab allocated & must be freed accordingly.*/
@@ -740,9 +777,11 @@ struct ldlm_lock {
 	struct ldlm_resource	*l_resource;
 	/**
 	 * List item for client side LRU list.
-	 * Protected by ns_lock in struct ldlm_namespace.
+	 * Protected by nl_lock of the namespace LRU part \a l_lru_cpt.
 	 */
 	struct list_head	l_lru;
+	/** CPU partition of the namespace LRU part this lock is cached in */
+	int			l_lru_cpt;
 	/**
 	 * Linkage to resource's lock queues according to current lock state.
 	 * (could be granted or waiting)
@@ -829,12 +868,12 @@ struct ldlm_lock {
 	 */
 	__u32			l_readers;
 	__u32			l_writers;
-	/**
-	 * If the lock is granted, a process sleeps on this waitq to learn when
-	 * it's no longer in use.  If the lock is not granted, a process sleeps
-	 * on this waitq to learn when it becomes granted.
+	/*
+	 * If the lock is granted, a process sleeps to learn when it's no
+	 * longer in use.  If the lock is not granted, a process sleeps to
+	 * learn when it becomes granted.  Few locks ever have waiters, so they
+	 * share hashed wait queues, see ldlm_lock_waitq().
 	 */
-	wait_queue_head_t	l_waitq;
 
 	/**
 	 * Time, in nanoseconds, last used by e.g. being matched by lock match.
@@ -987,6 +1026,10 @@ struct ldlm_resource {
 	 * protected by ns_lock
 	 */
 	struct hlist_node	lr_hash;
+	/** Linkage to \a ns_rs_rhash of the namespace */
+	struct rhash_head	lr_rhash;
+	/** Resources are freed after RCU grace period for lockless lookups */
+	struct rcu_head		lr_rcu;
 
 	/** Reference count for this resource */
 	atomic_t		lr_refcount;
@@ -1013,6 +1056,12 @@ struct ldlm_resource {
 	 */
 	struct ldlm_interval_tree *lr_itree;
 
+	/**
+	 * Recent write extents granted to clients (only for extent locks on
+	 * server side), used to limit lock expansion. Protected by lr_lock.
+	 */
+	struct ldlm_extent_history *lr_ext_hist;
+
 	union {
 		/**
 		 * When the resource was considered as contended,
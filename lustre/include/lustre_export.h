@@ -455,6 +455,11 @@ static inline int exp_connect_lock_convert(struct obd_export *exp)
 	return !!(exp_connect_flags2(exp) & OBD_CONNECT2_LOCK_CONVERT);
 }
 
+static inline int exp_connect_bl_ast_batch(struct obd_export *exp)
+{
+	return !!(exp_connect_flags2(exp) & OBD_CONNECT2_BL_AST_BATCH);
+}
+
 extern struct obd_export *class_conn2export(struct lustre_handle *conn);
 
 static inline int exp_connect_archive_id_array(struct obd_export *exp)
@@ -124,6 +124,8 @@
 #endif
 
 #define PTLRPC_NTHRS_INIT	2
+/** default seconds before an idle thread above threads_min exits */
+#define PTLRPC_NTHRS_IDLE_TIMEOUT	300
 
 /**
  * Buffer Constants
@@ -776,8 +778,12 @@ struct ptlrpc_cli_req {
 	time64_t			 cr_delay_limit;
 	/** time request was first queued */
 	time64_t			 cr_queued_time;
+	/** time request was queued in nanoseconds */
+	ktime_t				 cr_queued_ns;
 	/** request sent in nanoseconds */
 	ktime_t				 cr_sent_ns;
+	/** reply started being processed in nanoseconds */
+	ktime_t				 cr_replied_ns;
 	/** time for request really sent out */
 	time64_t			 cr_sent_out;
 	/** when req reply unlink must finish. */
@@ -1683,10 +1689,27 @@ struct ptlrpc_service {
 	int				srv_nthrs_cpt_init;
 	/** limit of threads number for each partition */
 	int				srv_nthrs_cpt_limit;
+	/**
+	 * threads starting or running in all partitions, never more than
+	 * srv_nthrs_cpt_limit * srv_ncpts (threads_max)
+	 */
+	atomic_t			srv_nthrs_total;
+	/**
+	 * seconds a thread above srv_nthrs_cpt_init may stay idle before it
+	 * exits, 0 to never stop idle threads
+	 */
+	int				srv_nthrs_idle_timeout;
+	/**
+	 * whether a busy partition may start threads beyond
+	 * srv_nthrs_cpt_limit while other partitions leave theirs unused
+	 */
+	bool				srv_nthrs_rebalance;
 	/** Root of debugfs dir tree for this service */
 	struct dentry		       *srv_debugfs_entry;
         /** Pointer to statistic data for this service */
         struct lprocfs_stats           *srv_stats;
+	/** per-stage latency histograms of handled requests */
+	struct ptlrpc_lat_stats		*srv_lat_stats;
         /** # hp per lp reqs to handle */
         int                             srv_hpreq_ratio;
         /** biggest request to receive */
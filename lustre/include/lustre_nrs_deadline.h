@@ -0,0 +1,123 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; If not, see
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * GPL HEADER END
+ */
+/*
+ *
+ * Network Request Scheduler (NRS) Deadline policy
+ *
+ */
+
+#ifndef _LUSTRE_NRS_DEADLINE_H
+#define _LUSTRE_NRS_DEADLINE_H
+
+/* \name deadline
+ *
+ * Deadline policy
+ * @{
+ */
+
+/**
+ * Latency classes of the deadline policy
+ */
+enum nrs_deadline_class {
+	NRS_DL_CLASS_INTERACTIVE = 0,
+	NRS_DL_CLASS_BULK,
+	NRS_DL_CLASS_MAX,
+};
+
+/** Maximum number of JobID patterns of the interactive class */
+#define NRS_DL_JOBID_MAX	8
+
+/**
+ * JobID patterns of the interactive class, used for passing them through
+ * nrs_deadline_ctl()
+ */
+struct nrs_deadline_jobids {
+	int		dj_count;
+	char		dj_jobid[NRS_DL_JOBID_MAX][LUSTRE_JOBID_SIZE];
+};
+
+/**
+ * Per-class statistics of the deadline policy
+ */
+struct nrs_deadline_stats {
+	/** requests handed out for handling */
+	__u64		ds_dispatched[NRS_DL_CLASS_MAX];
+	/** requests handed out after their deadline had passed */
+	__u64		ds_missed[NRS_DL_CLASS_MAX];
+};
+
+/**
+ * Private data structure for the deadline policy
+ */
+struct nrs_deadline_data {
+	struct ptlrpc_nrs_resource	 dl_res;
+
+	/**
+	 * Queued requests are stored in this binheap, ordered by their
+	 * (possibly boosted) deadline.
+	 */
+	struct cfs_binheap		*dl_binheap;
+
+	/**
+	 * Sequence number of the last enqueued request, used to keep FIFO
+	 * order between requests with the same deadline.
+	 */
+	__u64				 dl_sequence;
+
+	/**
+	 * Number of seconds by which the deadline of interactive requests is
+	 * moved ahead.
+	 */
+	__u32				 dl_boost;
+
+	/**
+	 * JobID patterns of the interactive class
+	 */
+	struct nrs_deadline_jobids	 dl_jobids;
+
+	struct nrs_deadline_stats	 dl_stats;
+};
+
+struct nrs_deadline_req {
+	/**
+	 * Deadline used for ordering, i.e. the request deadline at enqueue
+	 * time, minus the boost for interactive requests
+	 */
+	time64_t	dr_key;
+	/**
+	 * Deadline of the request at enqueue time
+	 */
+	time64_t	dr_deadline;
+	__u64		dr_sequence;
+	enum nrs_deadline_class dr_class;
+};
+
+enum nrs_ctl_deadline {
+	NRS_CTL_DEADLINE_RD_BOOST = PTLRPC_NRS_CTL_1ST_POL_SPEC,
+	NRS_CTL_DEADLINE_WR_BOOST,
+	NRS_CTL_DEADLINE_RD_JOBIDS,
+	NRS_CTL_DEADLINE_WR_JOBIDS,
+	NRS_CTL_DEADLINE_RD_STATS,
+};
+
+/** @} deadline */
+
+#endif
@@ -126,6 +126,15 @@ struct nrs_tbf_client {
 	bool				 tc_in_heap;
 	/** Sequence of the newest rule. */
 	__u32				 tc_rule_sequence;
+	/**
+	 * Virtual start tag of the next request dispatched on spare
+	 * capacity, see nrs_tbf_borrow_get().
+	 */
+	__u64				 tc_borrow_vtime;
+	/** Node in the heap of classes which may borrow. */
+	struct cfs_binheap_node		 tc_borrow_node;
+	/** Whether the client is in the borrow heap. */
+	bool				 tc_in_borrow_heap;
 	/**
 	 * Linkage into LRU list. Protected bucket lock of
 	 * nrs_tbf_head::th_cli_hash.
@@ -139,6 +148,7 @@ enum nrs_rule_flags {
 	NTRS_STOPPING	= 0x00000001,
 	NTRS_DEFAULT	= 0x00000002,
 	NTRS_REALTIME	= 0x00000004,
+	NTRS_BORROW	= 0x00000008,
 };
 
 struct nrs_tbf_rule {
@@ -262,10 +272,22 @@ struct nrs_tbf_head {
 	 * Sequence of requests.
 	 */
 	__u64				 th_sequence;
+	/**
+	 * Number of active rules which may borrow spare capacity.
+	 */
+	atomic_t			 th_borrow_rules;
+	/**
+	 * Virtual time of spare capacity sharing among borrowing classes.
+	 */
+	__u64				 th_borrow_vtime;
 	/**
 	 * Heap of queues.
 	 */
 	struct cfs_binheap		*th_binheap;
+	/**
+	 * Heap of queued classes which may borrow, by tc_borrow_vtime.
+	 */
+	struct cfs_binheap		*th_borrow_heap;
 	/**
 	 * Hash of clients.
 	 */
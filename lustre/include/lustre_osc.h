@@ -539,6 +539,11 @@ struct osc_page {
 	 * If the page is in osc_object::oo_tree.
 	 */
 				ops_intree:1;
+	/**
+	 * Index of the client_obd::cl_lru_shards list the page is on. Not a
+	 * bitfield, it is set under the shard lock only, see osc_lru_lock().
+	 */
+	unsigned char		ops_lru_shard;
 	/**
 	 * lru page list. See osc_lru_{del|use}() in osc_page.c for usage.
 	 */
@@ -161,6 +161,14 @@ enum obd_cl_sem_lock_class {
 
 struct mdc_rpc_lock;
 struct obd_import;
+/* number of LRU lists per client_obd, must fit in osc_page::ops_lru_shard */
+#define CL_LRU_SHARDS	8
+
+struct cl_lru_shard {
+	spinlock_t		cls_lock;
+	struct list_head	cls_list;
+} ____cacheline_aligned_in_smp;
+
 struct client_obd {
 	struct rw_semaphore	 cl_sem;
 	struct obd_uuid		 cl_target_uuid;
@@ -259,6 +267,23 @@ struct client_obd {
 	atomic_t		cl_pending_r_pages;
 	u32			cl_max_pages_per_rpc;
 	u32			cl_max_rpcs_in_flight;
+	/* adaptive RPC concurrency, see osc_rpc_window_update(). The current
+	 * window replaces cl_max_rpcs_in_flight as the limit of BRW RPCs in
+	 * flight, 0 if adaptive mode is disabled. Protected by
+	 * cl_loi_list_lock. */
+	u32			cl_rpc_window;
+	u32			cl_rpc_window_acks;
+	u32			cl_rpc_window_rounds;
+	u64			cl_rpc_rtt_min_us;
+	u64			cl_rpc_rtt_avg_us;
+	/* measured write drain bandwidth in KiB/s, used to split the dirty
+	 * cache among OSCs, see osc_dirty_budget(). cl_write_bw and
+	 * cl_write_bw_list are protected by osc_write_bw_lock, the rest by
+	 * cl_loi_list_lock. */
+	unsigned long		cl_write_bw;
+	struct list_head	cl_write_bw_list;
+	u64			cl_write_bw_bytes;
+	ktime_t			cl_write_bw_stamp;
 	u32			cl_max_short_io_bytes;
 	struct obd_histogram	cl_read_rpc_hist;
 	struct obd_histogram	cl_write_rpc_hist;
@@ -291,10 +316,11 @@ struct client_obd {
 	 * reclaim is sync, initiated by IO thread when the LRU slots are
 	 * in shortage. */
 	__u64                    cl_lru_reclaim;
-	/** List of LRU pages for this client_obd */
-	struct list_head         cl_lru_list;
-	/** Lock for LRU page list */
-	spinlock_t		 cl_lru_list_lock;
+	/** LRU pages of this client_obd, sharded by CPU to reduce contention
+	 * on the list lock. See osc_lru_add_batch(). */
+	struct cl_lru_shard	 cl_lru_shards[CL_LRU_SHARDS];
+	/** Shard that the next LRU shrink starts with */
+	atomic_t		 cl_lru_shard_next;
 	/** # of unstable pages in this client_obd.
 	 * An unstable page is a page state that WRITE RPC has finished but
 	 * the transaction has NOT yet committed. */
@@ -727,6 +753,8 @@ struct obd_device {
 	struct proc_dir_entry	*obd_proc_exports_entry;
 	struct dentry			*obd_svc_debugfs_entry;
 	struct lprocfs_stats	*obd_svc_stats;
+	/* per-stage latency histograms of completed RPCs */
+	struct ptlrpc_lat_stats	*obd_svc_lat_stats;
 	const struct attribute	       **obd_attrs;
 	struct lprocfs_vars	*obd_vars;
 	atomic_t		obd_evict_inprogress;
@@ -263,6 +263,94 @@ ldlm_extent_internal_policy_waiting(struct ldlm_lock *req,
         EXIT;
 }
 
+/**
+ * Limit the expanded write extent to the region the client is really using.
+ *
+ * Greedy expansion hands out everything up to the nearest conflicting lock,
+ * which for N-to-1 writers usually covers the regions other clients are
+ * about to write, so the lock gets called back right away. Remember the
+ * write extents recently granted on the resource and:
+ * - don't grow over the extents other clients have written recently
+ *   (partitioned access, each client moves through its own region);
+ * - grant only the requested extent if another client wrote between the
+ *   previous extent of this client and the current one (strided access).
+ *
+ * The history is allocated only once the resource sees conflicting locks,
+ * entries older than ns_contention_time are ignored.
+ */
+static void ldlm_extent_history_policy(struct ldlm_lock *req,
+				       struct ldlm_extent *new_ex)
+{
+	struct ldlm_resource *res = req->l_resource;
+	struct ldlm_namespace *ns = ldlm_res_to_ns(res);
+	struct ldlm_extent_history *hist = res->lr_ext_hist;
+	struct ldlm_extent_access *prev = NULL;
+	struct ldlm_extent_access *ea;
+	__u64 req_start = req->l_req_extent.start;
+	__u64 req_end = req->l_req_extent.end;
+	__u64 start = new_ex->start;
+	__u64 end = new_ex->end;
+	time64_t now = ktime_get_seconds();
+	int i;
+
+	if (!ns->ns_expand_history || !(req->l_req_mode & (LCK_PW | LCK_CW)))
+		return;
+
+	if (hist == NULL) {
+		/* no conflicts, stay greedy */
+		if (new_ex->start == 0 && new_ex->end == OBD_OBJECT_EOF)
+			return;
+
+		OBD_ALLOC_GFP(hist, sizeof(*hist), GFP_ATOMIC);
+		if (hist == NULL)
+			return;
+		res->lr_ext_hist = hist;
+	}
+
+	/* walk from the newest entry */
+	for (i = 1; i <= LDLM_EXTENT_HISTORY_SIZE; i++) {
+		ea = &hist->eh_ring[(hist->eh_next - i) %
+				    LDLM_EXTENT_HISTORY_SIZE];
+		if (ea->ea_export == NULL ||
+		    ea->ea_time + ns->ns_contention_time < now)
+			break;
+
+		if (ea->ea_export == req->l_export) {
+			if (prev == NULL && ea->ea_end < req_start)
+				prev = ea;
+			continue;
+		}
+
+		if (ea->ea_end < req_start)
+			start = max(start, ea->ea_end + 1);
+		else if (ea->ea_start > req_end)
+			end = min(end, ea->ea_start - 1);
+	}
+
+	if (prev != NULL && start > prev->ea_end) {
+		/* somebody else wrote right after our previous extent */
+		start = req_start;
+		end = req_end;
+	}
+
+	if (start != new_ex->start || end != new_ex->end) {
+		LDLM_DEBUG(req, "access history limits extent to [%llu->%llu]",
+			   start, end);
+		new_ex->start = start;
+		new_ex->end = end;
+		ldlm_extent_internal_policy_fixup(req, new_ex, 0);
+	}
+
+	ea = &hist->eh_ring[(hist->eh_next - 1) % LDLM_EXTENT_HISTORY_SIZE];
+	if (ea->ea_export != req->l_export || ea->ea_start != req_start ||
+	    ea->ea_end != req_end)
+		ea = &hist->eh_ring[hist->eh_next++ % LDLM_EXTENT_HISTORY_SIZE];
+
+	ea->ea_export = req->l_export;
+	ea->ea_start = req_start;
+	ea->ea_end = req_end;
+	ea->ea_time = now;
+}
 
 /* In order to determine the largest possible extent we can grant, we need
  * to scan all of the queues. */
@@ -292,6 +380,7 @@ static void ldlm_extent_policy(struct ldlm_resource *res,
 	if (likely(!(lock->l_flags & LDLM_FL_NO_EXPANSION))) {
 		ldlm_extent_internal_policy_granted(lock, &new_ex);
 		ldlm_extent_internal_policy_waiting(lock, &new_ex);
+		ldlm_extent_history_policy(lock, &new_ex);
 	} else {
 		LDLM_DEBUG(lock, "Not expanding manually requested lock.\n");
 		new_ex.start = lock->l_policy_data.l_extent.start;
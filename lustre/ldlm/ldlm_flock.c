@@ -680,7 +680,7 @@ ldlm_flock_completion_ast(struct ldlm_lock *lock, __u64 flags, void *data)
 			/* mds granted the lock in the reply */
 			goto granted;
 		/* CP AST RPC: lock get granted, wake it up */
-		wake_up(&lock->l_waitq);
+		wake_up(ldlm_lock_waitq(lock));
 		RETURN(0);
 	}
 
@@ -702,7 +702,8 @@ ldlm_flock_completion_ast(struct ldlm_lock *lock, __u64 flags, void *data)
         lwi = LWI_TIMEOUT_INTR(0, NULL, ldlm_flock_interrupted_wait, &fwd);
 
         /* Go to sleep until the lock is granted. */
-        rc = l_wait_event(lock->l_waitq, is_granted_or_cancelled(lock), &lwi);
+	rc = l_wait_event(*ldlm_lock_waitq(lock),
+			  is_granted_or_cancelled(lock), &lwi);
 
         if (rc) {
                 LDLM_DEBUG(lock, "client-side enqueue waking up: failed (%d)",
@@ -772,7 +773,7 @@ granted:
 		unlock_res_and_lock(lock);
 
 		/* Need to wake up the waiter if we were evicted */
-		wake_up(&lock->l_waitq);
+		wake_up(ldlm_lock_waitq(lock));
 
 		/* An error is still to be returned, to propagate it up to
 		 * ldlm_cli_enqueue_fini() caller. */
@@ -111,6 +111,7 @@ enum ldlm_lru_flags {
 					 * discarded momentarily */
 };
 
+int ldlm_request_bufsize(int count, int type);
 int ldlm_cancel_lru(struct ldlm_namespace *ns, int nr,
 		    enum ldlm_cancel_flags cancel_flags,
 		    enum ldlm_lru_flags lru_flags);
@@ -169,6 +170,12 @@ int ldlm_run_ast_work(struct ldlm_namespace *ns, struct list_head *rpc_list,
 		      ldlm_desc_ast_t ast_type);
 int ldlm_work_gl_ast_lock(struct ptlrpc_request_set *rqset, void *opaq);
 int ldlm_lock_remove_from_lru_check(struct ldlm_lock *lock, ktime_t last_use);
+/* Returns the part of the namespace LRU which \a lock belongs to. */
+static inline struct ldlm_ns_lru *ldlm_lock_lru(struct ldlm_lock *lock)
+{
+	return ldlm_lock_to_ns(lock)->ns_lru[lock->l_lru_cpt];
+}
+
 #define ldlm_lock_remove_from_lru(lock) \
 		ldlm_lock_remove_from_lru_check(lock, ktime_set(0, 0))
 int ldlm_lock_remove_from_lru_nolock(struct ldlm_lock *lock);
@@ -176,6 +183,8 @@ void ldlm_lock_add_to_lru_nolock(struct ldlm_lock *lock);
 void ldlm_lock_add_to_lru(struct ldlm_lock *lock);
 void ldlm_lock_touch_in_lru(struct ldlm_lock *lock);
 void ldlm_lock_destroy_nolock(struct ldlm_lock *lock);
+wait_queue_head_t *ldlm_lock_waitq(struct ldlm_lock *lock);
+void ldlm_lock_waitq_init(void);
 
 int ldlm_export_cancel_blocked_locks(struct obd_export *exp);
 int ldlm_export_cancel_locks(struct obd_export *exp);
@@ -189,6 +198,9 @@ int ldlm_bl_to_thread_list(struct ldlm_namespace *ns,
 			   struct list_head *cancels, int count,
 			   enum ldlm_cancel_flags cancel_flags);
 int ldlm_bl_thread_wakeup(void);
+#ifdef HAVE_SERVER_SUPPORT
+void ldlm_bl_batch_flush(struct ldlm_cb_set_arg *arg);
+#endif
 
 void ldlm_handle_bl_callback(struct ldlm_namespace *ns,
                              struct ldlm_lock_desc *ld, struct ldlm_lock *lock);
@@ -205,6 +217,23 @@ int ldlm_process_inodebits_lock(struct ldlm_lock *lock, __u64 *flags,
 				enum ldlm_error *err,
 				struct list_head *work_list);
 /* ldlm_extent.c */
+#define LDLM_EXTENT_HISTORY_SIZE	16
+
+/** Write extent granted to a client, see ldlm_extent_history_policy() */
+struct ldlm_extent_access {
+	/* only compared, never dereferenced */
+	struct obd_export	*ea_export;
+	__u64			 ea_start;
+	__u64			 ea_end;
+	time64_t		 ea_time;
+};
+
+struct ldlm_extent_history {
+	/* slot to be overwritten next */
+	unsigned int			eh_next;
+	struct ldlm_extent_access	eh_ring[LDLM_EXTENT_HISTORY_SIZE];
+};
+
 int ldlm_process_extent_lock(struct ldlm_lock *lock, __u64 *flags,
 			     enum ldlm_process_intention intention,
 			     enum ldlm_error *err, struct list_head *work_list);
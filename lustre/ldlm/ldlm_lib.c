@@ -275,6 +275,7 @@ int client_obd_setup(struct obd_device *obddev, struct lustre_cfg *lcfg)
 	struct ptlrpc_connection fake_conn = { .c_self = 0,
 					       .c_remote_uuid.uuid[0] = 0 };
 	int rc;
+	int i;
 	ENTRY;
 
 	/* In a more perfect world, we would hang a ptlrpc_client off of
@@ -374,6 +375,7 @@ int client_obd_setup(struct obd_device *obddev, struct lustre_cfg *lcfg)
 	atomic_set(&cli->cl_pending_r_pages, 0);
 	cli->cl_r_in_flight = 0;
 	cli->cl_w_in_flight = 0;
+	cli->cl_rpc_window = 0;
 
 	spin_lock_init(&cli->cl_read_rpc_hist.oh_lock);
 	spin_lock_init(&cli->cl_write_rpc_hist.oh_lock);
@@ -387,13 +389,17 @@ int client_obd_setup(struct obd_device *obddev, struct lustre_cfg *lcfg)
 	atomic_set(&cli->cl_lru_shrinkers, 0);
 	atomic_long_set(&cli->cl_lru_busy, 0);
 	atomic_long_set(&cli->cl_lru_in_list, 0);
-	INIT_LIST_HEAD(&cli->cl_lru_list);
-	spin_lock_init(&cli->cl_lru_list_lock);
+	for (i = 0; i < CL_LRU_SHARDS; i++) {
+		INIT_LIST_HEAD(&cli->cl_lru_shards[i].cls_list);
+		spin_lock_init(&cli->cl_lru_shards[i].cls_lock);
+	}
+	atomic_set(&cli->cl_lru_shard_next, 0);
 	atomic_long_set(&cli->cl_unstable_count, 0);
 	INIT_LIST_HEAD(&cli->cl_shrink_list);
 	INIT_LIST_HEAD(&cli->cl_grant_chain);
 
 	INIT_LIST_HEAD(&cli->cl_flight_waiters);
+	INIT_LIST_HEAD(&cli->cl_write_bw_list);
 	cli->cl_rpcs_in_flight = 0;
 
 	init_waitqueue_head(&cli->cl_destroy_waitq);
@@ -2842,29 +2848,34 @@ int target_queue_recovery_request(struct ptlrpc_request *req,
                 RETURN(0);
         }
 
-	/* XXX O(n^2) */
+	/* Each client replays in transno order and the recovery thread
+	 * consumes the lowest transnos, so a new replay nearly always belongs
+	 * at the end of the queue. Search from the tail, which keeps queueing
+	 * the replays of many clients close to O(n) instead of O(n^2). */
 	spin_lock(&obd->obd_recovery_task_lock);
 	LASSERT(obd->obd_recovering);
-	list_for_each_entry(reqiter, &obd->obd_req_replay_queue, rq_list) {
-		if (lustre_msg_get_transno(reqiter->rq_reqmsg) > transno) {
-			list_add_tail(&req->rq_list, &reqiter->rq_list);
+	list_for_each_entry_reverse(reqiter, &obd->obd_req_replay_queue,
+				    rq_list) {
+		__u64 itertransno = lustre_msg_get_transno(reqiter->rq_reqmsg);
+
+		if (itertransno < transno) {
+			list_add(&req->rq_list, &reqiter->rq_list);
 			inserted = 1;
 			goto added;
 		}
 
-                if (unlikely(lustre_msg_get_transno(reqiter->rq_reqmsg) ==
-                             transno)) {
-                        DEBUG_REQ(D_ERROR, req, "dropping replay: transno "
-                                  "has been claimed by another client");
+		if (unlikely(itertransno == transno)) {
+			DEBUG_REQ(D_ERROR, req, "dropping replay: transno "
+				  "has been claimed by another client");
 			spin_unlock(&obd->obd_recovery_task_lock);
-                        target_exp_dequeue_req_replay(req);
-                        target_request_copy_put(req);
-                        RETURN(0);
-                }
-        }
+			target_exp_dequeue_req_replay(req);
+			target_request_copy_put(req);
+			RETURN(0);
+		}
+	}
 added:
-        if (!inserted)
-		list_add_tail(&req->rq_list, &obd->obd_req_replay_queue);
+	if (!inserted)
+		list_add(&req->rq_list, &obd->obd_req_replay_queue);
 
         obd->obd_requests_queued_for_recovery++;
 	spin_unlock(&obd->obd_recovery_task_lock);
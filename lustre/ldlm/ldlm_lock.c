@@ -138,6 +138,29 @@ EXPORT_SYMBOL(ldlm_it2str);
 
 extern struct kmem_cache *ldlm_lock_slab;
 
+/*
+ * Processes waiting for a lock to be granted, cancelled or unused sleep on
+ * one of these queues, hashed by the lock address, instead of a wait queue
+ * in every lock. Only a small fraction of locks ever has waiters, while a
+ * server can hold millions of locks. Waiters re-check their condition, so a
+ * wakeup for another lock sharing the queue is harmless.
+ */
+#define LDLM_LOCK_WAITQ_BITS	8
+static wait_queue_head_t ldlm_lock_waitqs[1 << LDLM_LOCK_WAITQ_BITS];
+
+wait_queue_head_t *ldlm_lock_waitq(struct ldlm_lock *lock)
+{
+	return &ldlm_lock_waitqs[hash_ptr(lock, LDLM_LOCK_WAITQ_BITS)];
+}
+
+void ldlm_lock_waitq_init(void)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(ldlm_lock_waitqs); i++)
+		init_waitqueue_head(&ldlm_lock_waitqs[i]);
+}
+
 #ifdef HAVE_SERVER_SUPPORT
 static ldlm_processing_policy ldlm_processing_policy_table[] = {
 	[LDLM_PLAIN]	= ldlm_process_plain_lock,
@@ -225,20 +248,24 @@ void ldlm_lock_put(struct ldlm_lock *lock)
 EXPORT_SYMBOL(ldlm_lock_put);
 
 /**
- * Removes LDLM lock \a lock from LRU. Assumes LRU is already locked.
+ * Removes LDLM lock \a lock from LRU. Assumes the LRU part of the lock is
+ * already locked.
  */
 int ldlm_lock_remove_from_lru_nolock(struct ldlm_lock *lock)
 {
 	int rc = 0;
 	if (!list_empty(&lock->l_lru)) {
 		struct ldlm_namespace *ns = ldlm_lock_to_ns(lock);
+		struct ldlm_ns_lru *lru = ldlm_lock_lru(lock);
 
 		LASSERT(lock->l_resource->lr_type != LDLM_FLOCK);
-		if (ns->ns_last_pos == &lock->l_lru)
-			ns->ns_last_pos = lock->l_lru.prev;
+		if (lru->nl_last_pos == &lock->l_lru)
+			lru->nl_last_pos = lock->l_lru.prev;
 		list_del_init(&lock->l_lru);
-		LASSERT(ns->ns_nr_unused > 0);
-		ns->ns_nr_unused--;
+		LASSERT(lru->nl_nr_unused > 0);
+		lru->nl_nr_unused--;
+		LASSERT(atomic_read(&ns->ns_nr_unused) > 0);
+		atomic_dec(&ns->ns_nr_unused);
 		rc = 1;
 	}
 	return rc;
@@ -257,7 +284,7 @@ int ldlm_lock_remove_from_lru_nolock(struct ldlm_lock *lock)
  */
 int ldlm_lock_remove_from_lru_check(struct ldlm_lock *lock, ktime_t last_use)
 {
-	struct ldlm_namespace *ns = ldlm_lock_to_ns(lock);
+	struct ldlm_ns_lru *lru;
 	int rc = 0;
 
 	ENTRY;
@@ -266,28 +293,33 @@ int ldlm_lock_remove_from_lru_check(struct ldlm_lock *lock, ktime_t last_use)
 		RETURN(0);
 	}
 
-	spin_lock(&ns->ns_lock);
+	lru = ldlm_lock_lru(lock);
+	spin_lock(&lru->nl_lock);
 	if (!ktime_compare(last_use, ktime_set(0, 0)) ||
 	    !ktime_compare(last_use, lock->l_last_used))
 		rc = ldlm_lock_remove_from_lru_nolock(lock);
-	spin_unlock(&ns->ns_lock);
+	spin_unlock(&lru->nl_lock);
 
 	RETURN(rc);
 }
 
 /**
- * Adds LDLM lock \a lock to namespace LRU. Assumes LRU is already locked.
+ * Adds LDLM lock \a lock to namespace LRU. Assumes the LRU part of the lock
+ * is already locked.
  */
 void ldlm_lock_add_to_lru_nolock(struct ldlm_lock *lock)
 {
 	struct ldlm_namespace *ns = ldlm_lock_to_ns(lock);
+	struct ldlm_ns_lru *lru = ldlm_lock_lru(lock);
 
 	lock->l_last_used = ktime_get();
 	LASSERT(list_empty(&lock->l_lru));
 	LASSERT(lock->l_resource->lr_type != LDLM_FLOCK);
-	list_add_tail(&lock->l_lru, &ns->ns_unused_list);
-	LASSERT(ns->ns_nr_unused >= 0);
-	ns->ns_nr_unused++;
+	list_add_tail(&lock->l_lru, &lru->nl_list);
+	LASSERT(lru->nl_nr_unused >= 0);
+	lru->nl_nr_unused++;
+	LASSERT(atomic_read(&ns->ns_nr_unused) >= 0);
+	atomic_inc(&ns->ns_nr_unused);
 }
 
 /**
@@ -296,12 +328,12 @@ void ldlm_lock_add_to_lru_nolock(struct ldlm_lock *lock)
  */
 void ldlm_lock_add_to_lru(struct ldlm_lock *lock)
 {
-	struct ldlm_namespace *ns = ldlm_lock_to_ns(lock);
+	struct ldlm_ns_lru *lru = ldlm_lock_lru(lock);
 
 	ENTRY;
-	spin_lock(&ns->ns_lock);
+	spin_lock(&lru->nl_lock);
 	ldlm_lock_add_to_lru_nolock(lock);
-	spin_unlock(&ns->ns_lock);
+	spin_unlock(&lru->nl_lock);
 	EXIT;
 }
 
@@ -311,7 +343,7 @@ void ldlm_lock_add_to_lru(struct ldlm_lock *lock)
  */
 void ldlm_lock_touch_in_lru(struct ldlm_lock *lock)
 {
-	struct ldlm_namespace *ns = ldlm_lock_to_ns(lock);
+	struct ldlm_ns_lru *lru;
 
 	ENTRY;
 	if (ldlm_is_ns_srv(lock)) {
@@ -320,12 +352,13 @@ void ldlm_lock_touch_in_lru(struct ldlm_lock *lock)
 		return;
 	}
 
-	spin_lock(&ns->ns_lock);
+	lru = ldlm_lock_lru(lock);
+	spin_lock(&lru->nl_lock);
 	if (!list_empty(&lock->l_lru)) {
 		ldlm_lock_remove_from_lru_nolock(lock);
 		ldlm_lock_add_to_lru_nolock(lock);
 	}
-	spin_unlock(&ns->ns_lock);
+	spin_unlock(&lru->nl_lock);
 	EXIT;
 }
 
@@ -465,11 +498,12 @@ static struct ldlm_lock *ldlm_lock_new(struct ldlm_resource *resource)
 	atomic_set(&lock->l_refc, 2);
 	INIT_LIST_HEAD(&lock->l_res_link);
 	INIT_LIST_HEAD(&lock->l_lru);
+	/* keep the lock in the LRU part of the CPT it is enqueued from */
+	lock->l_lru_cpt = cfs_cpt_current(cfs_cpt_table, 1);
 	INIT_LIST_HEAD(&lock->l_pending_chain);
 	INIT_LIST_HEAD(&lock->l_bl_ast);
 	INIT_LIST_HEAD(&lock->l_cp_ast);
 	INIT_LIST_HEAD(&lock->l_rk_ast);
-	init_waitqueue_head(&lock->l_waitq);
 	lock->l_blocking_lock = NULL;
 	INIT_LIST_HEAD(&lock->l_sl_mode);
 	INIT_LIST_HEAD(&lock->l_sl_policy);
@@ -1304,7 +1338,7 @@ void ldlm_lock_fail_match_locked(struct ldlm_lock *lock)
 {
 	if ((lock->l_flags & LDLM_FL_FAIL_NOTIFIED) == 0) {
 		lock->l_flags |= LDLM_FL_FAIL_NOTIFIED;
-		wake_up_all(&lock->l_waitq);
+		wake_up_all(ldlm_lock_waitq(lock));
 	}
 }
 EXPORT_SYMBOL(ldlm_lock_fail_match_locked);
@@ -1326,7 +1360,7 @@ void ldlm_lock_fail_match(struct ldlm_lock *lock)
 void ldlm_lock_allow_match_locked(struct ldlm_lock *lock)
 {
 	ldlm_set_lvb_ready(lock);
-	wake_up_all(&lock->l_waitq);
+	wake_up_all(ldlm_lock_waitq(lock));
 }
 EXPORT_SYMBOL(ldlm_lock_allow_match_locked);
 
@@ -1455,7 +1489,7 @@ enum ldlm_mode ldlm_lock_match(struct ldlm_namespace *ns, __u64 flags,
                                                NULL, LWI_ON_SIGNAL_NOOP, NULL);
 
 			/* XXX FIXME see comment on CAN_MATCH in lustre_dlm.h */
-			l_wait_event(lock->l_waitq,
+			l_wait_event(*ldlm_lock_waitq(lock),
 				     lock->l_flags & wait_flags,
 				     &lwi);
 			if (!ldlm_is_lvb_ready(lock)) {
@@ -2052,8 +2086,13 @@ ldlm_work_bl_ast_lock(struct ptlrpc_request_set *rqset, void *opaq)
 
 	ENTRY;
 
-	if (list_empty(arg->list))
-		RETURN(-ENOENT);
+	if (list_empty(arg->list)) {
+		if (arg->bl_batch == NULL)
+			RETURN(-ENOENT);
+		/* send the last batched blocking AST */
+		ldlm_bl_batch_flush(arg);
+		RETURN(0);
+	}
 
 	lock = list_entry(arg->list->next, struct ldlm_lock, l_bl_ast);
 
@@ -2117,8 +2156,12 @@ ldlm_work_revoke_ast_lock(struct ptlrpc_request_set *rqset, void *opaq)
 	struct ldlm_lock       *lock;
 	ENTRY;
 
-	if (list_empty(arg->list))
-		RETURN(-ENOENT);
+	if (list_empty(arg->list)) {
+		if (arg->bl_batch == NULL)
+			RETURN(-ENOENT);
+		ldlm_bl_batch_flush(arg);
+		RETURN(0);
+	}
 
 	lock = list_entry(arg->list->next, struct ldlm_lock, l_rk_ast);
 	list_del_init(&lock->l_rk_ast);
@@ -2276,6 +2319,7 @@ int ldlm_run_ast_work(struct ldlm_namespace *ns, struct list_head *rpc_list,
 
 	ptlrpc_set_wait(NULL, arg->set);
 	ptlrpc_set_destroy(arg->set);
+	LASSERT(arg->bl_batch == NULL);
 
 	rc = atomic_read(&arg->restart) ? -ERESTART : 0;
 	GOTO(out, rc);
@@ -2390,14 +2434,14 @@ void ldlm_cancel_callback(struct ldlm_lock *lock)
 
 		/* only canceller can set bl_done bit */
 		ldlm_set_bl_done(lock);
-		wake_up_all(&lock->l_waitq);
+		wake_up_all(ldlm_lock_waitq(lock));
 	} else if (!ldlm_is_bl_done(lock)) {
 		struct l_wait_info lwi = { 0 };
 
 		/* The lock is guaranteed to have been canceled once
 		 * returning from this function. */
 		unlock_res_and_lock(lock);
-		l_wait_event(lock->l_waitq, is_bl_done(lock), &lwi);
+		l_wait_event(*ldlm_lock_waitq(lock), is_bl_done(lock), &lwi);
 		lock_res_and_lock(lock);
 	}
 }
@@ -111,6 +111,8 @@ struct ldlm_bl_work_item {
 	struct ldlm_lock_desc	blwi_ld;
 	struct ldlm_lock	*blwi_lock;
 	struct list_head	blwi_head;
+	/* locks of a batched blocking AST, blwi_count slots at most */
+	struct ldlm_lock	**blwi_locks;
 	int			blwi_count;
 	struct completion	blwi_comp;
 	enum ldlm_cancel_flags	blwi_flags;
@@ -796,6 +798,321 @@ static inline int ldlm_ast_fini(struct ptlrpc_request *req,
 	RETURN(rc);
 }
 
+/**
+ * Blocking ASTs for several locks granted to the same export, sent as one
+ * LDLM_BL_CALLBACK RPC with all the lock handles packed in ldlm_request.
+ * Only used for clients connected with OBD_CONNECT2_BL_AST_BATCH.
+ */
+struct ldlm_bl_batch {
+	struct ptlrpc_request	*bb_req;
+	struct obd_export	*bb_export;
+	int			 bb_count;
+	struct ldlm_lock	*bb_locks[LDLM_BL_BATCH_MAX];
+};
+
+static void ldlm_bl_batch_update_resend(struct ptlrpc_request *req,
+					void *data)
+{
+	struct ldlm_cb_async_args *ca = data;
+	struct ldlm_bl_batch *batch = ca->ca_batch;
+	int i;
+
+	for (i = 0; i < batch->bb_count; i++)
+		ldlm_refresh_waiting_lock(batch->bb_locks[i],
+					  ldlm_bl_timeout(batch->bb_locks[i]));
+}
+
+/**
+ * Send a separate blocking AST for \a lock which was part of a batch the
+ * client partially failed, so that ldlm_cb_interpret() can tell which of
+ * the locks the client really has lost.
+ */
+static int ldlm_bl_batch_resend(struct ldlm_lock *lock,
+				const struct ldlm_request *batch_body,
+				struct ldlm_cb_set_arg *arg)
+{
+	struct ldlm_cb_async_args *ca;
+	struct ldlm_request *body;
+	struct ptlrpc_request *req;
+	int rc;
+	ENTRY;
+
+	if (ldlm_is_destroyed(lock))
+		RETURN(0);
+
+	req = ptlrpc_request_alloc_pack(lock->l_export->exp_imp_reverse,
+					&RQF_LDLM_BL_CALLBACK,
+					LUSTRE_DLM_VERSION, LDLM_BL_CALLBACK);
+	if (req == NULL)
+		RETURN(-ENOMEM);
+
+	ca = ptlrpc_req_async_args(req);
+	ca->ca_set_arg = arg;
+	ca->ca_lock = lock;
+
+	req->rq_interpret_reply = ldlm_cb_interpret;
+
+	body = req_capsule_client_get(&req->rq_pill, &RMF_DLM_REQ);
+	body->lock_handle[0] = lock->l_remote_handle;
+	body->lock_desc = batch_body->lock_desc;
+	body->lock_flags = batch_body->lock_flags;
+
+	LDLM_DEBUG(lock, "server resending blocking AST out of batch");
+
+	ptlrpc_request_set_replen(req);
+	ldlm_refresh_waiting_lock(lock, ldlm_bl_timeout(lock));
+
+	req->rq_delay_limit = ldlm_bl_timeout(lock);
+	req->rq_resend_cb = ldlm_update_resend;
+	req->rq_send_state = LUSTRE_IMP_FULL;
+	if (AT_OFF)
+		req->rq_timeout = ldlm_get_rq_timeout();
+
+	/* the set producer is usually gone by now, the request is sent by
+	 * the next ptlrpc_check_set() pass over the set */
+	rc = ldlm_ast_fini(req, arg, lock, 0);
+
+	RETURN(rc);
+}
+
+static int ldlm_cb_batch_interpret(const struct lu_env *env,
+				   struct ptlrpc_request *req, void *data,
+				   int rc)
+{
+	struct ldlm_cb_async_args *ca = data;
+	struct ldlm_bl_batch *batch = ca->ca_batch;
+	struct ldlm_cb_set_arg *arg = ca->ca_set_arg;
+	struct ldlm_request *body;
+	int i;
+	ENTRY;
+
+	LASSERT(batch != NULL);
+
+	body = req_capsule_client_get(&req->rq_pill, &RMF_DLM_REQ);
+	for (i = 0; i < batch->bb_count; i++) {
+		struct ldlm_lock *lock = batch->bb_locks[i];
+		int rc2;
+
+		if (rc == -EINVAL && req->rq_replied) {
+			/* The client lost some of the locks but the reply
+			 * does not tell which ones, ask for each lock
+			 * separately instead of cancelling all of them. */
+			rc2 = ldlm_bl_batch_resend(lock, body, arg);
+			if (rc2 != 0)
+				LDLM_ERROR(lock,
+					   "cannot resend blocking AST: rc = %d",
+					   rc2);
+		} else if (rc != 0) {
+			rc2 = ldlm_handle_ast_error(env, lock, req, rc,
+						    "blocking");
+			if (rc2 == -ERESTART)
+				atomic_inc(&arg->restart);
+		}
+
+		/* release extra reference taken in ldlm_bl_batch_add() */
+		LDLM_LOCK_RELEASE(lock);
+	}
+
+	OBD_FREE_PTR(batch);
+
+	RETURN(0);
+}
+
+/**
+ * Send the blocking AST batch being filled in \a arg, if any.
+ *
+ * Called when a lock cannot join the current batch, when the batch is full
+ * and by the AST set producers once their lock list is drained.
+ */
+void ldlm_bl_batch_flush(struct ldlm_cb_set_arg *arg)
+{
+	struct ldlm_bl_batch *batch = arg->bl_batch;
+	struct ptlrpc_request *req;
+	struct ldlm_request *body;
+	ENTRY;
+
+	if (batch == NULL)
+		RETURN_EXIT;
+
+	arg->bl_batch = NULL;
+	req = batch->bb_req;
+
+	if (batch->bb_count == 0) {
+		/* all the locks went away before they could be added */
+		ptlrpc_req_finished(req);
+		OBD_FREE_PTR(batch);
+		RETURN_EXIT;
+	}
+
+	body = req_capsule_client_get(&req->rq_pill, &RMF_DLM_REQ);
+	body->lock_count = batch->bb_count;
+	req_capsule_shrink(&req->rq_pill, &RMF_DLM_REQ,
+			   ldlm_request_bufsize(batch->bb_count,
+						LDLM_BL_CALLBACK),
+			   RCL_CLIENT);
+
+	CDEBUG(D_DLMTRACE, "%s: sending blocking AST for %d locks to %s\n",
+	       batch->bb_export->exp_obd->obd_name, batch->bb_count,
+	       obd_export_nid2str(batch->bb_export));
+
+	ptlrpc_set_add_req(arg->set, req);
+	EXIT;
+}
+
+static bool ldlm_bl_batch_match(struct ldlm_bl_batch *batch,
+				struct ldlm_lock *lock,
+				struct ldlm_lock_desc *desc, __u64 flags)
+{
+	struct ldlm_request *body;
+
+	if (batch->bb_export != lock->l_export ||
+	    batch->bb_count >= LDLM_BL_BATCH_MAX)
+		return false;
+
+	body = req_capsule_client_get(&batch->bb_req->rq_pill, &RMF_DLM_REQ);
+
+	return body->lock_flags == flags &&
+	       body->lock_desc.l_resource.lr_type ==
+	       desc->l_resource.lr_type &&
+	       ldlm_res_eq(&body->lock_desc.l_resource.lr_name,
+			   &desc->l_resource.lr_name) &&
+	       body->lock_desc.l_req_mode == desc->l_req_mode &&
+	       body->lock_desc.l_granted_mode == desc->l_granted_mode &&
+	       memcmp(&body->lock_desc.l_policy_data, &desc->l_policy_data,
+		      sizeof(desc->l_policy_data)) == 0;
+}
+
+static struct ldlm_bl_batch *ldlm_bl_batch_new(struct ldlm_lock *lock,
+					       struct ldlm_lock_desc *desc,
+					       __u64 flags,
+					       struct ldlm_cb_set_arg *arg)
+{
+	struct ldlm_cb_async_args *ca;
+	struct ldlm_bl_batch *batch;
+	struct ldlm_request *body;
+	struct ptlrpc_request *req;
+	int rc;
+
+	OBD_ALLOC_PTR(batch);
+	if (batch == NULL)
+		return NULL;
+
+	req = ptlrpc_request_alloc(lock->l_export->exp_imp_reverse,
+				   &RQF_LDLM_BL_CALLBACK);
+	if (req == NULL)
+		GOTO(out_free, rc = -ENOMEM);
+
+	/* room for the largest batch, shrunk in ldlm_bl_batch_flush() */
+	req_capsule_set_size(&req->rq_pill, &RMF_DLM_REQ, RCL_CLIENT,
+			     ldlm_request_bufsize(LDLM_BL_BATCH_MAX,
+						  LDLM_BL_CALLBACK));
+	rc = ptlrpc_request_pack(req, LUSTRE_DLM_VERSION, LDLM_BL_CALLBACK);
+	if (rc) {
+		ptlrpc_request_free(req);
+		GOTO(out_free, rc);
+	}
+
+	ca = ptlrpc_req_async_args(req);
+	ca->ca_set_arg = arg;
+	ca->ca_lock = NULL;
+	ca->ca_batch = batch;
+
+	req->rq_interpret_reply = ldlm_cb_batch_interpret;
+
+	body = req_capsule_client_get(&req->rq_pill, &RMF_DLM_REQ);
+	body->lock_desc = *desc;
+	body->lock_flags = flags;
+
+	ptlrpc_request_set_replen(req);
+
+	/* Do not resend after lock callback timeout */
+	req->rq_delay_limit = ldlm_bl_timeout(lock);
+	req->rq_resend_cb = ldlm_bl_batch_update_resend;
+	req->rq_send_state = LUSTRE_IMP_FULL;
+	/* ptlrpc_request_pack already set timeout */
+	if (AT_OFF)
+		req->rq_timeout = ldlm_get_rq_timeout();
+
+	batch->bb_req = req;
+	batch->bb_export = lock->l_export;
+
+	return batch;
+
+out_free:
+	OBD_FREE_PTR(batch);
+	return NULL;
+}
+
+/**
+ * Add blocking AST for \a lock to the batch being built for its export,
+ * starting a new batch if the lock cannot join the current one.
+ */
+static int ldlm_bl_batch_add(struct ldlm_lock *lock,
+			     struct ldlm_lock_desc *desc,
+			     struct ldlm_cb_set_arg *arg)
+{
+	struct ldlm_bl_batch *batch = arg->bl_batch;
+	struct ldlm_request *body;
+	__u64 flags;
+	ENTRY;
+
+	/* AST flags were set before the lock was put on the AST list */
+	flags = ldlm_flags_to_wire(lock->l_flags & LDLM_FL_AST_MASK);
+
+	if (batch != NULL && !ldlm_bl_batch_match(batch, lock, desc, flags)) {
+		ldlm_bl_batch_flush(arg);
+		batch = NULL;
+	}
+
+	if (batch == NULL) {
+		batch = ldlm_bl_batch_new(lock, desc, flags, arg);
+		if (batch == NULL)
+			RETURN(-ENOMEM);
+		arg->bl_batch = batch;
+	}
+
+	lock_res_and_lock(lock);
+	if (ldlm_is_destroyed(lock)) {
+		/* What's the point? */
+		unlock_res_and_lock(lock);
+		RETURN(0);
+	}
+
+	if (lock->l_granted_mode != lock->l_req_mode) {
+		/* this blocking AST will be communicated as part of the
+		 * completion AST instead */
+		ldlm_add_blocked_lock(lock);
+		ldlm_set_waited(lock);
+		unlock_res_and_lock(lock);
+
+		LDLM_DEBUG(lock, "lock not granted, not sending blocking AST");
+		RETURN(0);
+	}
+
+	body = req_capsule_client_get(&batch->bb_req->rq_pill, &RMF_DLM_REQ);
+	body->lock_handle[batch->bb_count] = lock->l_remote_handle;
+
+	LDLM_DEBUG(lock, "server adding blocking AST to batch of %d",
+		   batch->bb_count + 1);
+
+	ldlm_set_cbpending(lock);
+	ldlm_add_waiting_lock(lock, ldlm_bl_timeout(lock));
+	unlock_res_and_lock(lock);
+
+	LDLM_LOCK_GET(lock);
+	batch->bb_locks[batch->bb_count++] = lock;
+
+	if (lock->l_export->exp_nid_stats &&
+	    lock->l_export->exp_nid_stats->nid_ldlm_stats)
+		lprocfs_counter_incr(lock->l_export->exp_nid_stats->nid_ldlm_stats,
+				     LDLM_BL_CALLBACK - LDLM_FIRST_OPC);
+
+	if (batch->bb_count == LDLM_BL_BATCH_MAX)
+		ldlm_bl_batch_flush(arg);
+
+	RETURN(0);
+}
+
 /**
  * Check if there are requests in the export request list which prevent
  * the lock canceling and make these requests high priority ones.
@@ -863,6 +1180,11 @@ int ldlm_server_blocking_ast(struct ldlm_lock *lock,
 
         ldlm_lock_reorder_req(lock);
 
+	/* coalesce blocking ASTs for locks of the same client */
+	if (exp_connect_bl_ast_batch(lock->l_export) &&
+	    !ldlm_is_cancel_on_block(lock))
+		RETURN(ldlm_bl_batch_add(lock, desc, arg));
+
 	req = ptlrpc_request_alloc_pack(lock->l_export->exp_imp_reverse,
 					&RQF_LDLM_BL_CALLBACK,
 					LUSTRE_DLM_VERSION, LDLM_BL_CALLBACK);
@@ -1896,7 +2218,7 @@ out:
 		lock_res_and_lock(lock);
 		ldlm_set_failed(lock);
 		unlock_res_and_lock(lock);
-		wake_up(&lock->l_waitq);
+		wake_up(ldlm_lock_waitq(lock));
 	}
 	LDLM_LOCK_RELEASE(lock);
 }
@@ -1967,8 +2289,10 @@ static int __ldlm_bl_to_thread(struct ldlm_bl_work_item *blwi,
 	ENTRY;
 
 	spin_lock(&blp->blp_lock);
-	if (blwi->blwi_lock &&
-	    ldlm_is_discard_data(blwi->blwi_lock)) {
+	if ((blwi->blwi_lock &&
+	     ldlm_is_discard_data(blwi->blwi_lock)) ||
+	    (blwi->blwi_locks &&
+	     ldlm_is_discard_data(blwi->blwi_locks[0]))) {
 		/* add LDLM_FL_DISCARD_DATA requests to the priority list */
 		list_add_tail(&blwi->blwi_entry, &blp->blp_prio_list);
 	} else {
@@ -2068,6 +2392,29 @@ int ldlm_bl_to_thread_list(struct ldlm_namespace *ns, struct ldlm_lock_desc *ld,
 	return ldlm_bl_to_thread(ns, ld, NULL, cancels, count, cancel_flags);
 }
 
+/**
+ * Queues locks from a batched blocking AST as a single work item, the
+ * blocking thread runs ldlm_handle_bl_callback() for each of them and frees
+ * \a locks array of \a count slots afterwards. Unused slots are NULL.
+ */
+static int ldlm_bl_to_thread_batch(struct ldlm_namespace *ns,
+				   struct ldlm_lock_desc *ld,
+				   struct ldlm_lock **locks, int count)
+{
+	struct ldlm_bl_work_item *blwi;
+	ENTRY;
+
+	OBD_ALLOC(blwi, sizeof(*blwi));
+	if (blwi == NULL)
+		RETURN(-ENOMEM);
+
+	init_blwi(blwi, ns, ld, NULL, 0, NULL, LCF_ASYNC);
+	blwi->blwi_locks = locks;
+	blwi->blwi_count = count;
+
+	RETURN(__ldlm_bl_to_thread(blwi, LCF_ASYNC));
+}
+
 int ldlm_bl_thread_wakeup(void)
 {
 	wake_up(&ldlm_state->ldlm_bl_pool->blp_waitq);
@@ -2133,6 +2480,114 @@ static inline void ldlm_callback_errmsg(struct ptlrpc_request *req,
 }
 
 /* TODO: handle requests in a similar way as MDT: see mdt_handle_common() */
+/**
+ * Look up client lock \a lockh named in a batched blocking AST and mark it
+ * the same way ldlm_callback_handler() does for a single lock.
+ *
+ * \retval referenced lock, or NULL if the client does not have it anymore
+ */
+static struct ldlm_lock *ldlm_bl_batch_lock(const struct lustre_handle *lockh,
+					    __u64 wire_flags)
+{
+	struct ldlm_lock *lock;
+
+	lock = ldlm_handle2lock_long(lockh, 0);
+	if (!lock) {
+		CDEBUG(D_DLMTRACE, "callback on lock %#llx - lock "
+		       "disappeared\n", lockh->cookie);
+		return NULL;
+	}
+
+	lock_res_and_lock(lock);
+	lock->l_flags |= ldlm_flags_from_wire(wire_flags & LDLM_FL_AST_MASK);
+	if ((ldlm_is_canceling(lock) && ldlm_is_bl_done(lock)) ||
+	    ldlm_is_failed(lock)) {
+		LDLM_DEBUG(lock, "callback on lock %llx - lock disappeared",
+			   lockh->cookie);
+		unlock_res_and_lock(lock);
+		LDLM_LOCK_RELEASE(lock);
+		return NULL;
+	}
+	ldlm_lock_remove_from_lru(lock);
+	ldlm_set_bl_ast(lock);
+	unlock_res_and_lock(lock);
+
+	return lock;
+}
+
+/**
+ * Handle blocking AST for several locks at once.
+ *
+ * The server packs all locks of this client conflicting with one enqueue
+ * into a single LDLM_BL_CALLBACK. The reply is -EINVAL if any of the locks
+ * is gone already, the server then resends blocking ASTs one by one to find
+ * out which. Found locks are handed to one blocking thread work item.
+ */
+static void ldlm_handle_bl_batch(struct ptlrpc_request *req,
+				 struct ldlm_namespace *ns,
+				 struct ldlm_request *dlm_req)
+{
+	struct ldlm_lock **locks;
+	struct ldlm_lock *lock;
+	int count;
+	int found = 0;
+	int rc = 0;
+	int i;
+	ENTRY;
+
+	/* servers never batch more than LDLM_BL_BATCH_MAX locks, check that
+	 * before the count is used to size anything */
+	if (dlm_req->lock_count > LDLM_BL_BATCH_MAX) {
+		rc = ldlm_callback_reply(req, -EPROTO);
+		ldlm_callback_errmsg(req, "Operate with too many handles", rc,
+				     NULL);
+		RETURN_EXIT;
+	}
+
+	count = dlm_req->lock_count;
+	if (req_capsule_get_size(&req->rq_pill, &RMF_DLM_REQ, RCL_CLIENT) <
+	    ldlm_request_bufsize(count, LDLM_BL_CALLBACK)) {
+		rc = ldlm_callback_reply(req, -EPROTO);
+		ldlm_callback_errmsg(req, "Operate with short handle list", rc,
+				     NULL);
+		RETURN_EXIT;
+	}
+
+	CDEBUG(D_INODE, "blocking ast for %d locks\n", count);
+	req_capsule_extend(&req->rq_pill, &RQF_LDLM_BL_CALLBACK);
+
+	OBD_ALLOC(locks, count * sizeof(*locks));
+	for (i = 0; i < count; i++) {
+		lock = ldlm_bl_batch_lock(&dlm_req->lock_handle[i],
+					  dlm_req->lock_flags);
+		if (lock == NULL) {
+			rc = -EINVAL;
+			continue;
+		}
+
+		if (locks != NULL)
+			locks[found++] = lock;
+		else if (ldlm_bl_to_thread_lock(ns, &dlm_req->lock_desc, lock))
+			ldlm_handle_bl_callback(ns, &dlm_req->lock_desc, lock);
+	}
+
+	rc = ldlm_callback_reply(req, rc);
+	if (req->rq_no_reply || rc)
+		ldlm_callback_errmsg(req, "Batch process", rc, NULL);
+
+	if (locks == NULL)
+		RETURN_EXIT;
+
+	if (found == 0 ||
+	    ldlm_bl_to_thread_batch(ns, &dlm_req->lock_desc, locks, count)) {
+		for (i = 0; i < found; i++)
+			ldlm_handle_bl_callback(ns, &dlm_req->lock_desc,
+						locks[i]);
+		OBD_FREE(locks, count * sizeof(*locks));
+	}
+	EXIT;
+}
+
 static int ldlm_callback_handler(struct ptlrpc_request *req)
 {
         struct ldlm_namespace *ns;
@@ -2202,6 +2657,12 @@ static int ldlm_callback_handler(struct ptlrpc_request *req)
                 RETURN(0);
         }
 
+	if (lustre_msg_get_opc(req->rq_reqmsg) == LDLM_BL_CALLBACK &&
+	    dlm_req->lock_count > 1) {
+		ldlm_handle_bl_batch(req, ns, dlm_req);
+		RETURN(0);
+	}
+
         /* Force a known safe race, send a cancel to the server for a lock
          * which the server has already started a blocking callback on. */
         if (OBD_FAIL_CHECK(OBD_FAIL_LDLM_CANCEL_BL_CB_RACE) &&
@@ -2644,7 +3105,18 @@ static int ldlm_bl_thread_blwi(struct ldlm_bl_pool *blp,
 
 	OBD_FAIL_TIMEOUT(OBD_FAIL_LDLM_PAUSE_CANCEL2, 4);
 
-	if (blwi->blwi_count) {
+	if (blwi->blwi_locks) {
+		int i;
+
+		for (i = 0; i < blwi->blwi_count; i++) {
+			if (blwi->blwi_locks[i] == NULL)
+				break;
+			ldlm_handle_bl_callback(blwi->blwi_ns, &blwi->blwi_ld,
+						blwi->blwi_locks[i]);
+		}
+		OBD_FREE(blwi->blwi_locks,
+			 blwi->blwi_count * sizeof(*blwi->blwi_locks));
+	} else if (blwi->blwi_count) {
 		int count;
 		/* The special case when we cancel locks in lru
 		 * asynchronously, we pass the list of locks here.
@@ -3182,6 +3654,8 @@ static int ldlm_cleanup(void)
 
 int ldlm_init(void)
 {
+	ldlm_lock_waitq_init();
+
 	ldlm_resource_slab = kmem_cache_create("ldlm_resources",
 					       sizeof(struct ldlm_resource), 0,
 					       SLAB_HWCACHE_ALIGN, NULL);
@@ -3236,6 +3710,8 @@ void ldlm_exit(void)
 {
 	if (ldlm_refcount)
 		CERROR("ldlm_refcount is %d in ldlm_exit!\n", ldlm_refcount);
+	/* ldlm_resource_putref() frees resources after RCU grace period */
+	rcu_barrier();
 	kmem_cache_destroy(ldlm_resource_slab);
 	/* ldlm_lock_put() use RCU to call ldlm_lock_free, so need call
 	 * synchronize_rcu() to wait a grace period elapsed, so that
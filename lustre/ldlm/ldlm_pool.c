@@ -550,9 +550,7 @@ static int ldlm_cli_pool_shrink(struct ldlm_pool *pl,
          */
         ldlm_cli_pool_pop_slv(pl);
 
-	spin_lock(&ns->ns_lock);
-	unused = ns->ns_nr_unused;
-	spin_unlock(&ns->ns_lock);
+	unused = atomic_read(&ns->ns_nr_unused);
 
 	if (nr == 0)
 		return (unused / 100) * sysctl_vfs_cache_pressure;
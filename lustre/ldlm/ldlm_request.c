@@ -216,7 +216,7 @@ int ldlm_completion_ast_async(struct ldlm_lock *lock, __u64 flags, void *data)
 	}
 
 	if (!(flags & LDLM_FL_BLOCKED_MASK)) {
-		wake_up(&lock->l_waitq);
+		wake_up(ldlm_lock_waitq(lock));
 		RETURN(ldlm_completion_tail(lock, data));
 	}
 
@@ -263,7 +263,7 @@ int ldlm_completion_ast(struct ldlm_lock *lock, __u64 flags, void *data)
         }
 
 	if (!(flags & LDLM_FL_BLOCKED_MASK)) {
-		wake_up(&lock->l_waitq);
+		wake_up(ldlm_lock_waitq(lock));
 		RETURN(0);
 	}
 
@@ -306,8 +306,8 @@ noreproc:
                 rc = -EINTR;
         } else {
                 /* Go to sleep until the lock is granted or cancelled. */
-                rc = l_wait_event(lock->l_waitq,
-                                  is_granted_or_cancelled(lock), &lwi);
+		rc = l_wait_event(*ldlm_lock_waitq(lock),
+				  is_granted_or_cancelled(lock), &lwi);
         }
 
         if (rc) {
@@ -1108,7 +1108,7 @@ static int lock_convert_interpret(const struct lu_env *env,
 		 * finish with convert otherwise.
 		 */
 		if (!ldlm_is_bl_ast(lock)) {
-			struct ldlm_namespace *ns = ldlm_lock_to_ns(lock);
+			struct ldlm_ns_lru *lru = ldlm_lock_lru(lock);
 
 			/* Drop cancel_bits since there are no more converts
 			 * and put lock into LRU if it is still not used and
@@ -1117,11 +1117,11 @@ static int lock_convert_interpret(const struct lu_env *env,
 			lock->l_policy_data.l_inodebits.cancel_bits = 0;
 			if (!lock->l_readers && !lock->l_writers &&
 			    !ldlm_is_canceling(lock)) {
-				spin_lock(&ns->ns_lock);
+				spin_lock(&lru->nl_lock);
 				/* there is check for list_empty() inside */
 				ldlm_lock_remove_from_lru_nolock(lock);
 				ldlm_lock_add_to_lru_nolock(lock);
-				spin_unlock(&ns->ns_lock);
+				spin_unlock(&lru->nl_lock);
 			}
 		}
 	}
@@ -1524,7 +1524,8 @@ int ldlm_cli_cancel(const struct lustre_handle *lockh,
 			struct l_wait_info lwi = { 0 };
 
 			unlock_res_and_lock(lock);
-			l_wait_event(lock->l_waitq, is_bl_done(lock), &lwi);
+			l_wait_event(*ldlm_lock_waitq(lock), is_bl_done(lock),
+				     &lwi);
 		}
 		LDLM_LOCK_RELEASE(lock);
 		RETURN(0);
@@ -1822,92 +1823,76 @@ ldlm_cancel_lru_policy(struct ldlm_namespace *ns, enum ldlm_lru_flags lru_flags)
 }
 
 /**
- * - Free space in LRU for \a count new locks,
- *   redundant unused locks are canceled locally;
- * - also cancel locally unused aged locks;
- * - do not cancel more than \a max locks;
- * - GET the found locks and add them into the \a cancels list.
- *
- * A client lock can be added to the l_bl_ast list only when it is
- * marked LDLM_FL_CANCELING. Otherwise, somebody is already doing
- * CANCEL.  There are the following use cases:
- * ldlm_cancel_resource_local(), ldlm_cancel_lru_local() and
- * ldlm_cli_cancel(), which check and set this flag properly. As any
- * attempt to cancel a lock rely on this flag, l_bl_ast list is accessed
- * later without any special locking.
- *
- * Calling policies for enabled LRU resize:
- * ----------------------------------------
- * flags & LDLM_LRU_FLAG_LRUR - use LRU resize policy (SLV from server) to
- *				cancel not more than \a count locks;
- *
- * flags & LDLM_LRU_FLAG_PASSED - cancel \a count number of old locks (located
- *				at the beginning of LRU list);
- *
- * flags & LDLM_LRU_FLAG_SHRINK - cancel not more than \a count locks according
- *				to memory pressre policy function;
- *
- * flags & LDLM_LRU_FLAG_AGED - cancel \a count locks according to "aged policy"
- *
- * flags & LDLM_LRU_FLAG_NO_WAIT - cancel as many unused locks as possible
- *				(typically before replaying locks) w/o
- *				sending any RPCs or waiting for any
- *				outstanding RPC to complete.
- *
- * flags & LDLM_CANCEL_CLEANUP - when cancelling read locks, do not check for
- * 				other read locks covering the same pages, just
- * 				discard those pages.
+ * Returns the first lock of LRU part \a lru which nobody is cancelling yet,
+ * dropping the cancelled ones from the list on the way. Called with
+ * \a lru locked.
  */
-static int ldlm_prepare_lru_list(struct ldlm_namespace *ns,
-				 struct list_head *cancels, int count, int max,
-				 enum ldlm_lru_flags lru_flags)
+static struct ldlm_lock *ldlm_lru_first(struct ldlm_ns_lru *lru, int no_wait)
 {
-	ldlm_cancel_lru_policy_t pf;
-	int added = 0;
-	int no_wait = lru_flags & LDLM_LRU_FLAG_NO_WAIT;
+	struct list_head *item, *next;
+	struct ldlm_lock *lock;
 
-	ENTRY;
+	item = no_wait ? lru->nl_last_pos : &lru->nl_list;
+	for (item = item->next, next = item->next;
+	     item != &lru->nl_list;
+	     item = next, next = item->next) {
+		lock = list_entry(item, struct ldlm_lock, l_lru);
 
-	if (!ns_connect_lru_resize(ns))
-		count += ns->ns_nr_unused - ns->ns_max_unused;
+		/* No locks which got blocking requests. */
+		LASSERT(!ldlm_is_bl_ast(lock));
 
-	pf = ldlm_cancel_lru_policy(ns, lru_flags);
-	LASSERT(pf != NULL);
+		if (!ldlm_is_canceling(lock) &&
+		    !ldlm_is_converting(lock))
+			return lock;
 
-	/* For any flags, stop scanning if @max is reached. */
-	while (!list_empty(&ns->ns_unused_list) && (max == 0 || added < max)) {
-		struct ldlm_lock *lock;
-		struct list_head *item, *next;
-		enum ldlm_policy_res result;
-		ktime_t last_use = ktime_set(0, 0);
+		/* Somebody is already doing CANCEL. No need for this
+		 * lock in LRU, do not traverse it again. */
+		ldlm_lock_remove_from_lru_nolock(lock);
+	}
 
-		spin_lock(&ns->ns_lock);
-		item = no_wait ? ns->ns_last_pos : &ns->ns_unused_list;
-		for (item = item->next, next = item->next;
-		     item != &ns->ns_unused_list;
-		     item = next, next = item->next) {
-			lock = list_entry(item, struct ldlm_lock, l_lru);
+	return NULL;
+}
 
-			/* No locks which got blocking requests. */
-			LASSERT(!ldlm_is_bl_ast(lock));
+/**
+ * Returns the share of \a val for an LRU part holding \a nr of the \a total
+ * unused locks of the namespace, rounded up so that small parts are scanned
+ * too.
+ */
+static inline int ldlm_lru_share(int val, int nr, int total)
+{
+	return min_t(u64, val, div_u64((u64)val * nr + total - 1, total));
+}
 
-			if (!ldlm_is_canceling(lock) &&
-			    !ldlm_is_converting(lock))
-				break;
+/**
+ * Prepare the cancel list for LRU part \a lru alone, for at most \a max
+ * locks and \a count locks to be preferably canceled in this part, see
+ * ldlm_prepare_lru_list(). Only \a lru is locked, and only to pick the next
+ * lock to check.
+ */
+static int ldlm_prepare_lru_part(struct ldlm_namespace *ns,
+				 struct ldlm_ns_lru *lru,
+				 struct list_head *cancels, int count, int max,
+				 ldlm_cancel_lru_policy_t pf,
+				 enum ldlm_lru_flags lru_flags)
+{
+	int added = 0;
+	int no_wait = lru_flags & LDLM_LRU_FLAG_NO_WAIT;
 
-			/* Somebody is already doing CANCEL. No need for this
-			 * lock in LRU, do not traverse it again. */
-			ldlm_lock_remove_from_lru_nolock(lock);
-		}
-		if (item == &ns->ns_unused_list) {
-			spin_unlock(&ns->ns_lock);
+	/* For any flags, stop scanning if @max is reached. */
+	while (!list_empty(&lru->nl_list) && (max == 0 || added < max)) {
+		struct ldlm_lock *lock;
+		enum ldlm_policy_res result;
+		ktime_t last_use;
+
+		spin_lock(&lru->nl_lock);
+		lock = ldlm_lru_first(lru, no_wait);
+		if (lock != NULL)
+			LDLM_LOCK_GET(lock);
+		spin_unlock(&lru->nl_lock);
+		if (lock == NULL)
 			break;
-		}
 
 		last_use = lock->l_last_used;
-
-		LDLM_LOCK_GET(lock);
-		spin_unlock(&ns->ns_lock);
 		lu_ref_add(&lock->l_reference, __FUNCTION__, current);
 
 		/* Pass the lock through the policy filter and see if it
@@ -1923,7 +1908,8 @@ static int ldlm_prepare_lru_list(struct ldlm_namespace *ns,
 		 * old locks, but additionally choose them by
 		 * their weight. Big extent locks will stay in
 		 * the cache. */
-		result = pf(ns, lock, ns->ns_nr_unused, added, count);
+		result = pf(ns, lock, atomic_read(&ns->ns_nr_unused), added,
+			    count);
 		if (result == LDLM_POLICY_KEEP_LOCK) {
 			lu_ref_del(&lock->l_reference, __func__, current);
 			LDLM_LOCK_RELEASE(lock);
@@ -1933,11 +1919,11 @@ static int ldlm_prepare_lru_list(struct ldlm_namespace *ns,
 		if (result == LDLM_POLICY_SKIP_LOCK) {
 			lu_ref_del(&lock->l_reference, __func__, current);
 			if (no_wait) {
-				spin_lock(&ns->ns_lock);
+				spin_lock(&lru->nl_lock);
 				if (!list_empty(&lock->l_lru) &&
-				    lock->l_lru.prev == ns->ns_last_pos)
-					ns->ns_last_pos = &lock->l_lru;
-				spin_unlock(&ns->ns_lock);
+				    lock->l_lru.prev == lru->nl_last_pos)
+					lru->nl_last_pos = &lock->l_lru;
+				spin_unlock(&lru->nl_lock);
 			}
 
 			LDLM_LOCK_RELEASE(lock);
@@ -1993,6 +1979,94 @@ static int ldlm_prepare_lru_list(struct ldlm_namespace *ns,
 		lu_ref_del(&lock->l_reference, __FUNCTION__, current);
 		added++;
 	}
+	return added;
+}
+
+/**
+ * - Free space in LRU for \a count new locks,
+ *   redundant unused locks are canceled locally;
+ * - also cancel locally unused aged locks;
+ * - do not cancel more than \a max locks;
+ * - GET the found locks and add them into the \a cancels list.
+ *
+ * A client lock can be added to the l_bl_ast list only when it is
+ * marked LDLM_FL_CANCELING. Otherwise, somebody is already doing
+ * CANCEL.  There are the following use cases:
+ * ldlm_cancel_resource_local(), ldlm_cancel_lru_local() and
+ * ldlm_cli_cancel(), which check and set this flag properly. As any
+ * attempt to cancel a lock rely on this flag, l_bl_ast list is accessed
+ * later without any special locking.
+ *
+ * Calling policies for enabled LRU resize:
+ * ----------------------------------------
+ * flags & LDLM_LRU_FLAG_LRUR - use LRU resize policy (SLV from server) to
+ *				cancel not more than \a count locks;
+ *
+ * flags & LDLM_LRU_FLAG_PASSED - cancel \a count number of old locks (located
+ *				at the beginning of LRU list);
+ *
+ * flags & LDLM_LRU_FLAG_SHRINK - cancel not more than \a count locks according
+ *				to memory pressre policy function;
+ *
+ * flags & LDLM_LRU_FLAG_AGED - cancel \a count locks according to "aged policy"
+ *
+ * flags & LDLM_LRU_FLAG_NO_WAIT - cancel as many unused locks as possible
+ *				(typically before replaying locks) w/o
+ *				sending any RPCs or waiting for any
+ *				outstanding RPC to complete.
+ *
+ * flags & LDLM_CANCEL_CLEANUP - when cancelling read locks, do not check for
+ * 				other read locks covering the same pages, just
+ * 				discard those pages.
+ */
+static int ldlm_prepare_lru_list(struct ldlm_namespace *ns,
+				 struct list_head *cancels, int count, int max,
+				 enum ldlm_lru_flags lru_flags)
+{
+	ldlm_cancel_lru_policy_t pf;
+	struct ldlm_ns_lru *lru;
+	int nparts = cfs_percpt_number(ns->ns_lru);
+	int start = cfs_cpt_current(cfs_cpt_table, 1);
+	int total = 0;
+	int added = 0;
+	int i;
+
+	ENTRY;
+
+	if (!ns_connect_lru_resize(ns))
+		count += atomic_read(&ns->ns_nr_unused) - ns->ns_max_unused;
+
+	pf = ldlm_cancel_lru_policy(ns, lru_flags);
+	LASSERT(pf != NULL);
+
+	cfs_percpt_for_each(lru, i, ns->ns_lru)
+		total += READ_ONCE(lru->nl_nr_unused);
+	if (total == 0)
+		RETURN(0);
+
+	/* Every part is scanned on its own, oldest lock first, for its share
+	 * of @count and @max, so the order across parts is only roughly LRU.
+	 * Start with the local part, so that the parts which may use up @max
+	 * first are not always the same. */
+	for (i = 0; i < nparts && (max == 0 || added < max); i++) {
+		int part_count = count;
+		int part_max = max;
+		int nr;
+
+		lru = ns->ns_lru[(start + i) % nparts];
+		nr = READ_ONCE(lru->nl_nr_unused);
+		if (nr == 0)
+			continue;
+
+		if (count > 0)
+			part_count = ldlm_lru_share(count, nr, total);
+		if (max > 0)
+			part_max = min(ldlm_lru_share(max, nr, total),
+				       max - added);
+
+		added += ldlm_prepare_lru_part(ns, lru, cancels, part_count,
+					       part_max, pf, lru_flags);
+	}
 	RETURN(added);
 }
 
@@ -2504,12 +2578,13 @@ static void ldlm_cancel_unused_locks_for_replay(struct ldlm_namespace *ns)
 
 	CDEBUG(D_DLMTRACE, "Dropping as many unused locks as possible before"
 			   "replay for namespace %s (%d)\n",
-			   ldlm_ns_name(ns), ns->ns_nr_unused);
+			   ldlm_ns_name(ns), atomic_read(&ns->ns_nr_unused));
 
 	/* We don't need to care whether or not LRU resize is enabled
 	 * because the LDLM_LRU_FLAG_NO_WAIT policy doesn't use the
 	 * count parameter */
-	canceled = ldlm_cancel_lru_local(ns, &cancels, ns->ns_nr_unused, 0,
+	canceled = ldlm_cancel_lru_local(ns, &cancels,
+					 atomic_read(&ns->ns_nr_unused), 0,
 					 LCF_LOCAL, LDLM_LRU_FLAG_NO_WAIT);
 
 	CDEBUG(D_DLMTRACE, "Canceled %d unused locks from namespace %s\n",
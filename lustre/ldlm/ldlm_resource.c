@@ -289,11 +289,8 @@ void ldlm_debugfs_cleanup(void)
 	ldlm_debugfs_dir = NULL;
 }
 
-static ssize_t resource_count_show(struct kobject *kobj, struct attribute *attr,
-				   char *buf)
+static __u64 ldlm_ns_resource_count(struct ldlm_namespace *ns)
 {
-	struct ldlm_namespace *ns = container_of(kobj, struct ldlm_namespace,
-						 ns_kobj);
 	__u64			res = 0;
 	struct cfs_hash_bd		bd;
 	int			i;
@@ -301,7 +298,16 @@ static ssize_t resource_count_show(struct kobject *kobj, struct attribute *attr,
 	/* result is not strictly consistant */
 	cfs_hash_for_each_bucket(ns->ns_rs_hash, &bd, i)
 		res += cfs_hash_bd_count_get(&bd);
-	return sprintf(buf, "%lld\n", res);
+	return res;
+}
+
+static ssize_t resource_count_show(struct kobject *kobj, struct attribute *attr,
+				   char *buf)
+{
+	struct ldlm_namespace *ns = container_of(kobj, struct ldlm_namespace,
+						 ns_kobj);
+
+	return sprintf(buf, "%lld\n", ldlm_ns_resource_count(ns));
 }
 LUSTRE_RO_ATTR(resource_count);
 
@@ -318,6 +324,23 @@ static ssize_t lock_count_show(struct kobject *kobj, struct attribute *attr,
 }
 LUSTRE_RO_ATTR(lock_count);
 
+/* Memory held by the lock and resource structures of this namespace, in KiB.
+ * Extent interval nodes and LVBs are not included. */
+static ssize_t lock_memory_kb_show(struct kobject *kobj,
+				   struct attribute *attr, char *buf)
+{
+	struct ldlm_namespace *ns = container_of(kobj, struct ldlm_namespace,
+						 ns_kobj);
+	__u64			bytes;
+
+	bytes = lprocfs_stats_collector(ns->ns_stats, LDLM_NSS_LOCKS,
+					LPROCFS_FIELDS_FLAGS_SUM) *
+		sizeof(struct ldlm_lock);
+	bytes += ldlm_ns_resource_count(ns) * sizeof(struct ldlm_resource);
+	return sprintf(buf, "%llu\n", bytes >> 10);
+}
+LUSTRE_RO_ATTR(lock_memory_kb);
+
 static ssize_t lock_unused_count_show(struct kobject *kobj,
 				      struct attribute *attr,
 				      char *buf)
@@ -325,7 +348,7 @@ static ssize_t lock_unused_count_show(struct kobject *kobj,
 	struct ldlm_namespace *ns = container_of(kobj, struct ldlm_namespace,
 						 ns_kobj);
 
-	return sprintf(buf, "%d\n", ns->ns_nr_unused);
+	return sprintf(buf, "%d\n", atomic_read(&ns->ns_nr_unused));
 }
 LUSTRE_RO_ATTR(lock_unused_count);
 
@@ -334,11 +357,11 @@ static ssize_t lru_size_show(struct kobject *kobj, struct attribute *attr,
 {
 	struct ldlm_namespace *ns = container_of(kobj, struct ldlm_namespace,
 						 ns_kobj);
-	__u32 *nr = &ns->ns_max_unused;
+	__u32 nr = ns->ns_max_unused;
 
 	if (ns_connect_lru_resize(ns))
-		nr = &ns->ns_nr_unused;
-	return sprintf(buf, "%u\n", *nr);
+		nr = atomic_read(&ns->ns_nr_unused);
+	return sprintf(buf, "%u\n", nr);
 }
 
 static ssize_t lru_size_store(struct kobject *kobj, struct attribute *attr,
@@ -356,7 +379,7 @@ static ssize_t lru_size_store(struct kobject *kobj, struct attribute *attr,
                        ldlm_ns_name(ns));
                 if (ns_connect_lru_resize(ns)) {
 			/* Try to cancel all @ns_nr_unused locks. */
-			ldlm_cancel_lru(ns, ns->ns_nr_unused, 0,
+			ldlm_cancel_lru(ns, atomic_read(&ns->ns_nr_unused), 0,
 					LDLM_LRU_FLAG_PASSED |
 					LDLM_LRU_FLAG_CLEANUP);
 		} else {
@@ -377,16 +400,18 @@ static ssize_t lru_size_store(struct kobject *kobj, struct attribute *attr,
 	lru_resize = (tmp == 0);
 
 	if (ns_connect_lru_resize(ns)) {
+		unsigned int nr_unused = atomic_read(&ns->ns_nr_unused);
+
 		if (!lru_resize)
 			ns->ns_max_unused = (unsigned int)tmp;
 
-		if (tmp > ns->ns_nr_unused)
-			tmp = ns->ns_nr_unused;
-		tmp = ns->ns_nr_unused - tmp;
+		if (tmp > nr_unused)
+			tmp = nr_unused;
+		tmp = nr_unused - tmp;
 
 		CDEBUG(D_DLMTRACE,
 		       "changing namespace %s unused locks from %u to %u\n",
-		       ldlm_ns_name(ns), ns->ns_nr_unused,
+		       ldlm_ns_name(ns), nr_unused,
 		       (unsigned int)tmp);
 		ldlm_cancel_lru(ns, tmp, LCF_ASYNC, LDLM_LRU_FLAG_PASSED);
 
@@ -635,6 +660,34 @@ static ssize_t contended_locks_store(struct kobject *kobj,
 }
 LUSTRE_RW_ATTR(contended_locks);
 
+static ssize_t expand_history_show(struct kobject *kobj,
+				   struct attribute *attr, char *buf)
+{
+	struct ldlm_namespace *ns = container_of(kobj, struct ldlm_namespace,
+						 ns_kobj);
+
+	return sprintf(buf, "%u\n", ns->ns_expand_history);
+}
+
+static ssize_t expand_history_store(struct kobject *kobj,
+				    struct attribute *attr,
+				    const char *buffer, size_t count)
+{
+	struct ldlm_namespace *ns = container_of(kobj, struct ldlm_namespace,
+						 ns_kobj);
+	bool val;
+	int err;
+
+	err = kstrtobool(buffer, &val);
+	if (err)
+		return err;
+
+	ns->ns_expand_history = val;
+
+	return count;
+}
+LUSTRE_RW_ATTR(expand_history);
+
 static ssize_t max_parallel_ast_show(struct kobject *kobj,
 				     struct attribute *attr, char *buf)
 {
@@ -669,6 +722,7 @@ LUSTRE_RW_ATTR(max_parallel_ast);
 static struct attribute *ldlm_ns_attrs[] = {
 	&lustre_attr_resource_count.attr,
 	&lustre_attr_lock_count.attr,
+	&lustre_attr_lock_memory_kb.attr,
 	&lustre_attr_lock_unused_count.attr,
 	&lustre_attr_lru_size.attr,
 	&lustre_attr_lru_max_age.attr,
@@ -680,6 +734,7 @@ static struct attribute *ldlm_ns_attrs[] = {
 	&lustre_attr_max_nolock_bytes.attr,
 	&lustre_attr_contention_seconds.attr,
 	&lustre_attr_contended_locks.attr,
+	&lustre_attr_expand_history.attr,
 	&lustre_attr_max_parallel_ast.attr,
 #endif
 	NULL,
@@ -755,6 +810,13 @@ static int ldlm_namespace_debugfs_register(struct ldlm_namespace *ns)
 }
 #undef MAX_STRING_SIZE
 
+static const struct rhashtable_params ldlm_res_rhash_params = {
+	.key_len		= sizeof(struct ldlm_res_id),
+	.key_offset		= offsetof(struct ldlm_resource, lr_name),
+	.head_offset		= offsetof(struct ldlm_resource, lr_rhash),
+	.automatic_shrinking	= true,
+};
+
 static unsigned ldlm_res_hop_hash(struct cfs_hash *hs,
                                   const void *key, unsigned mask)
 {
@@ -920,6 +982,7 @@ struct ldlm_namespace *ldlm_namespace_new(struct obd_device *obd, char *name,
 	struct ldlm_namespace *ns = NULL;
 	struct ldlm_ns_bucket *nsb;
 	struct ldlm_ns_hash_def *nsd;
+	struct ldlm_ns_lru *lru;
 	struct cfs_hash_bd bd;
 	int idx;
 	int rc;
@@ -975,8 +1038,22 @@ struct ldlm_namespace *ldlm_namespace_new(struct obd_device *obd, char *name,
 	if (!ns->ns_name)
 		goto out_hash;
 
+	rc = rhashtable_init(&ns->ns_rs_rhash, &ldlm_res_rhash_params);
+	if (rc)
+		GOTO(out_name, rc);
+
+	ns->ns_lru = cfs_percpt_alloc(cfs_cpt_table, sizeof(*lru));
+	if (!ns->ns_lru)
+		GOTO(out_rhash, NULL);
+
+	cfs_percpt_for_each(lru, idx, ns->ns_lru) {
+		spin_lock_init(&lru->nl_lock);
+		INIT_LIST_HEAD(&lru->nl_list);
+		lru->nl_nr_unused = 0;
+		lru->nl_last_pos = &lru->nl_list;
+	}
+
 	INIT_LIST_HEAD(&ns->ns_list_chain);
-	INIT_LIST_HEAD(&ns->ns_unused_list);
 	spin_lock_init(&ns->ns_lock);
 	atomic_set(&ns->ns_bref, 0);
 	init_waitqueue_head(&ns->ns_waitq);
@@ -984,9 +1061,10 @@ struct ldlm_namespace *ldlm_namespace_new(struct obd_device *obd, char *name,
 	ns->ns_max_nolock_size    = NS_DEFAULT_MAX_NOLOCK_BYTES;
 	ns->ns_contention_time    = NS_DEFAULT_CONTENTION_SECONDS;
 	ns->ns_contended_locks    = NS_DEFAULT_CONTENDED_LOCKS;
+	ns->ns_expand_history     = NS_DEFAULT_EXPAND_HISTORY;
 
         ns->ns_max_parallel_ast   = LDLM_DEFAULT_PARALLEL_AST_LIMIT;
-        ns->ns_nr_unused          = 0;
+	atomic_set(&ns->ns_nr_unused, 0);
         ns->ns_max_unused         = LDLM_DEFAULT_LRU_SIZE;
 	ns->ns_max_age            = ktime_set(LDLM_DEFAULT_MAX_ALIVE, 0);
         ns->ns_ctime_age_limit    = LDLM_CTIME_AGE_LIMIT;
@@ -996,12 +1074,11 @@ struct ldlm_namespace *ldlm_namespace_new(struct obd_device *obd, char *name,
         ns->ns_connect_flags      = 0;
         ns->ns_stopping           = 0;
 	ns->ns_reclaim_start	  = 0;
-	ns->ns_last_pos		  = &ns->ns_unused_list;
 
 	rc = ldlm_namespace_sysfs_register(ns);
 	if (rc) {
 		CERROR("Can't initialize ns sysfs, rc %d\n", rc);
-		GOTO(out_hash, rc);
+		GOTO(out_lru, rc);
 	}
 
 	rc = ldlm_namespace_debugfs_register(ns);
@@ -1024,8 +1101,13 @@ out_proc:
 out_sysfs:
 	ldlm_namespace_sysfs_unregister(ns);
 	ldlm_namespace_cleanup(ns, 0);
-out_hash:
+out_lru:
+	cfs_percpt_free(ns->ns_lru);
+out_rhash:
+	rhashtable_destroy(&ns->ns_rs_rhash);
+out_name:
 	kfree(ns->ns_name);
+out_hash:
 	cfs_hash_putref(ns->ns_rs_hash);
 out_ns:
         OBD_FREE_PTR(ns);
@@ -1291,6 +1373,8 @@ void ldlm_namespace_free_post(struct ldlm_namespace *ns)
 	ldlm_namespace_debugfs_unregister(ns);
 	ldlm_namespace_sysfs_unregister(ns);
 	cfs_hash_putref(ns->ns_rs_hash);
+	rhashtable_destroy(&ns->ns_rs_rhash);
+	cfs_percpt_free(ns->ns_lru);
 	kfree(ns->ns_name);
 	/* Namespace \a ns should be not on list at this time, otherwise
 	 * this will cause issues related to using freed \a ns in poold
@@ -1443,7 +1527,8 @@ static struct ldlm_resource *ldlm_resource_new(enum ldlm_type ldlm_type)
 /**
  * Return a reference to resource with given name, creating it if necessary.
  * Args: namespace with ns_lock unlocked
- * Locks: takes and releases NS hash-lock and res->lr_lock
+ * Locks: takes and releases NS hash-lock and res->lr_lock, unless the
+ *        resource is found by the lockless RCU lookup
  * Returns: referenced, unlocked ldlm_resource or NULL
  */
 struct ldlm_resource *
@@ -1456,12 +1541,27 @@ ldlm_resource_get(struct ldlm_namespace *ns, struct ldlm_resource *parent,
 	struct cfs_hash_bd		bd;
 	__u64			version;
 	int			ns_refcount = 0;
+	int			rc;
 
         LASSERT(ns != NULL);
         LASSERT(parent == NULL);
         LASSERT(ns->ns_rs_hash != NULL);
         LASSERT(name->name[0] != 0);
 
+	/* Fast path: resource is in the RCU index and still referenced.
+	 * A resource whose last reference is dropped is removed from both
+	 * tables under the bucket lock, so fall back to the locked lookup
+	 * below if it is found with zero references. */
+	rcu_read_lock();
+	res = rhashtable_lookup_fast(&ns->ns_rs_rhash, name,
+				     ldlm_res_rhash_params);
+	if (res != NULL && atomic_inc_not_zero(&res->lr_refcount)) {
+		rcu_read_unlock();
+		return res;
+	}
+	rcu_read_unlock();
+	res = NULL;
+
         cfs_hash_bd_get_and_lock(ns->ns_rs_hash, (void *)name, &bd, 0);
         hnode = cfs_hash_bd_lookup_locked(ns->ns_rs_hash, &bd, (void *)name);
         if (hnode != NULL) {
@@ -1504,6 +1604,13 @@ found:
 	}
 	/* We won! Let's add the resource. */
         cfs_hash_bd_add_locked(ns->ns_rs_hash, &bd, &res->lr_hash);
+	/* Failure to index the resource only costs the lockless lookups,
+	 * it is still found in ns_rs_hash. */
+	rc = rhashtable_insert_fast(&ns->ns_rs_rhash, &res->lr_rhash,
+				    ldlm_res_rhash_params);
+	if (rc)
+		CDEBUG(D_INFO, "%s: cannot index resource "DLDLMRES": rc = %d\n",
+		       ldlm_ns_name(ns), PLDLMRES(res), rc);
 	if (cfs_hash_bd_count_get(&bd) == 1)
 		ns_refcount = ldlm_namespace_get_return(ns);
 
@@ -1552,11 +1659,22 @@ static void __ldlm_resource_putref_final(struct cfs_hash_bd *bd,
 
 	cfs_hash_bd_del_locked(nsb->nsb_namespace->ns_rs_hash,
 			       bd, &res->lr_hash);
+	/* -ENOENT if the resource could not be indexed */
+	rhashtable_remove_fast(&nsb->nsb_namespace->ns_rs_rhash,
+			       &res->lr_rhash, ldlm_res_rhash_params);
 	lu_ref_fini(&res->lr_reference);
 	if (cfs_hash_bd_count_get(bd) == 0)
 		ldlm_namespace_put(nsb->nsb_namespace);
 }
 
+static void ldlm_resource_free_rcu(struct rcu_head *head)
+{
+	struct ldlm_resource *res = container_of(head, struct ldlm_resource,
+						 lr_rcu);
+
+	OBD_SLAB_FREE(res, ldlm_resource_slab, sizeof *res);
+}
+
 /* Returns 1 if the resource was freed, 0 if it remains. */
 int ldlm_resource_putref(struct ldlm_resource *res)
 {
@@ -1576,7 +1694,11 @@ int ldlm_resource_putref(struct ldlm_resource *res)
 		if (res->lr_itree != NULL)
 			OBD_SLAB_FREE(res->lr_itree, ldlm_interval_tree_slab,
 				      sizeof(*res->lr_itree) * LCK_MODE_NUM);
-		OBD_SLAB_FREE(res, ldlm_resource_slab, sizeof *res);
+#ifdef HAVE_SERVER_SUPPORT
+		if (res->lr_ext_hist != NULL)
+			OBD_FREE_PTR(res->lr_ext_hist);
+#endif
+		call_rcu(&res->lr_rcu, ldlm_resource_free_rcu);
 		return 1;
 	}
 	return 0;
@@ -1320,7 +1320,7 @@ static bool file_is_noatime(const struct file *file)
 
 static int ll_file_io_ptask(struct cfs_ptask *ptask);
 
-static void ll_io_init(struct cl_io *io, struct file *file, enum cl_io_type iot)
+void ll_io_init(struct cl_io *io, struct file *file, enum cl_io_type iot)
 {
 	struct inode *inode = file_inode(file);
 	struct ll_file_data *fd  = LUSTRE_FPRIVATE(file);
@@ -1330,6 +1330,7 @@ static void ll_io_init(struct cl_io *io, struct file *file, enum cl_io_type iot)
 	io->u.ci_rw.rw_file = file;
 	io->u.ci_rw.rw_ptask = ll_file_io_ptask;
 	io->u.ci_rw.rw_nonblock = !!(file->f_flags & O_NONBLOCK);
+	io->u.ci_rw.rw_direct = !!(file->f_flags & O_DIRECT);
 	io->ci_lock_no_expand = fd->ll_lock_no_expand;
 
 	if (iot == CIT_WRITE) {
@@ -1432,12 +1433,26 @@ static int ll_file_io_ptask(struct cfs_ptask *ptask)
 	RETURN(pt->cip_result > 0 ? 0 : rc);
 }
 
+/*
+ * Account the time elapsed since \a start in the range lock counter \a op,
+ * and restart the interval from now.
+ */
+static inline void ll_range_lock_tally(struct inode *inode, int op,
+				       ktime_t *start)
+{
+	ktime_t now = ktime_get();
+
+	ll_stats_ops_tally(ll_i2sbi(inode), op, ktime_us_delta(now, *start));
+	*start = now;
+}
+
 static ssize_t
 ll_file_io_generic(const struct lu_env *env, struct vvp_io_args *args,
 		   struct file *file, enum cl_io_type iot,
 		   loff_t *ppos, size_t count)
 {
 	struct range_lock	range;
+	ktime_t			range_time = ktime_set(0, 0);
 	struct vvp_io		*vio = vvp_env_io(env);
 	struct inode		*inode = file_inode(file);
 	struct ll_inode_info	*lli = ll_i2info(inode);
@@ -1487,11 +1502,14 @@ restart:
 			    !(vio->vui_fd->fd_flags & LL_FILE_GROUP_LOCKED)) {
 				CDEBUG(D_VFSTRACE, "Range lock "RL_FMT"\n",
 				       RL_PARA(&range));
+				range_time = ktime_get();
 				rc = range_lock(&lli->lli_write_tree, &range);
 				if (rc < 0)
 					GOTO(out, rc);
 
 				range_locked = true;
+				ll_range_lock_tally(inode, LPROC_LL_RANGE_LOCK_WAIT,
+						    &range_time);
 			}
 			break;
 		case IO_SPLICE:
@@ -1520,6 +1538,8 @@ restart:
 			CDEBUG(D_VFSTRACE, "Range unlock "RL_FMT"\n",
 			       RL_PARA(&range));
 			range_unlock(&lli->lli_write_tree, &range);
+			ll_range_lock_tally(inode, LPROC_LL_RANGE_LOCK_HOLD,
+					    &range_time);
 		}
 	} else {
 		/* cl_io_rw_init() handled IO */
@@ -1704,30 +1724,49 @@ out:
  * write to it without doing a full I/O, because Lustre already knows about it
  * and will write it out.  This saves a lot of processing time.
  *
- * All writes here are within one page, so exclusion is handled by the page
- * lock on the vm page.  We do not do tiny writes for writes which touch
- * multiple pages because it's very unlikely multiple sequential pages are
- * are already dirty.
- *
- * We limit these to < PAGE_SIZE because PAGE_SIZE writes are relatively common
- * and are unlikely to be to already dirty pages.
+ * We limit these to writes inside a single page, because large writes are
+ * unlikely to hit only already dirty pages, and setting up a full cl_io is
+ * cheap compared to the copy for them.  A write of the whole page is only
+ * tried if that page is dirty, so a cold page is not grabbed for nothing.
  *
  * Attribute updates are important here, we do them in ll_tiny_write_end.
  */
+/* Check without the page lock that the page at @index is dirty. */
+static bool ll_tiny_write_page_dirty(struct address_space *mapping,
+				     pgoff_t index)
+{
+	struct page *vmpage;
+	bool dirty;
+
+	vmpage = find_get_page(mapping, index);
+	if (vmpage == NULL)
+		return false;
+	dirty = PageDirty(vmpage) && !PageWriteback(vmpage);
+	put_page(vmpage);
+
+	return dirty;
+}
+
 static ssize_t ll_do_tiny_write(struct kiocb *iocb, struct iov_iter *iter)
 {
 	ssize_t count = iov_iter_count(iter);
 	struct file *file = iocb->ki_filp;
 	struct inode *inode = file_inode(file);
+	struct ll_inode_info *lli = ll_i2info(inode);
 	ssize_t result = 0;
 
 	ENTRY;
 
-	/* Restrict writes to single page and < PAGE_SIZE.  See comment at top
-	 * of function for why.
+	/* Restrict writes to a single page.  See comment at top of function
+	 * for why.
 	 */
-	if (count >= PAGE_SIZE ||
-	    (iocb->ki_pos & (PAGE_SIZE-1)) + count > PAGE_SIZE)
+	if (count == 0 || (iocb->ki_pos & (PAGE_SIZE - 1)) + count > PAGE_SIZE)
+		RETURN(0);
+
+	/* avoid grabbing a cold page for a whole page overwrite */
+	if (count == PAGE_SIZE &&
+	    !ll_tiny_write_page_dirty(file->f_mapping,
+				      iocb->ki_pos >> PAGE_SHIFT))
 		RETURN(0);
 
 	result = __generic_file_write_iter(iocb, iter);
@@ -1741,7 +1780,7 @@ static ssize_t ll_do_tiny_write(struct kiocb *iocb, struct iov_iter *iter)
 	if (result > 0) {
 		ll_stats_ops_tally(ll_i2sbi(inode), LPROC_LL_WRITE_BYTES,
 				   result);
-		ll_file_set_flag(ll_i2info(inode), LLIF_DATA_MODIFIED);
+		ll_file_set_flag(lli, LLIF_DATA_MODIFIED);
 	}
 
 	CDEBUG(D_VFSTRACE, "result: %zu, original count %zu\n", result, count);
@@ -4789,6 +4828,7 @@ struct file_operations ll_file_operations = {
 # endif
 	.read_iter	= ll_file_read_iter,
 	.write_iter	= ll_file_write_iter,
+	.splice_write	= iter_file_splice_write,
 #else /* !HAVE_FILE_OPERATIONS_READ_WRITE_ITER */
 	.read		= ll_file_read,
 	.aio_read	= ll_file_aio_read,
@@ -4813,6 +4853,7 @@ struct file_operations ll_file_operations_flock = {
 # endif /* HAVE_SYNC_READ_WRITE */
 	.read_iter	= ll_file_read_iter,
 	.write_iter	= ll_file_write_iter,
+	.splice_write	= iter_file_splice_write,
 #else /* !HAVE_FILE_OPERATIONS_READ_WRITE_ITER */
 	.read		= ll_file_read,
 	.aio_read	= ll_file_aio_read,
@@ -4840,6 +4881,7 @@ struct file_operations ll_file_operations_noflock = {
 # endif /* HAVE_SYNC_READ_WRITE */
 	.read_iter	= ll_file_read_iter,
 	.write_iter	= ll_file_write_iter,
+	.splice_write	= iter_file_splice_write,
 #else /* !HAVE_FILE_OPERATIONS_READ_WRITE_ITER */
 	.read		= ll_file_read,
 	.aio_read	= ll_file_aio_read,
@@ -358,14 +358,37 @@ enum ra_stat {
         RA_STAT_MAX_IN_FLIGHT,
         RA_STAT_WRONG_GRAB_PAGE,
 	RA_STAT_FAILED_REACH_END,
+	RA_STAT_ASYNC,
 	_NR_RA_STAT,
 };
 
+/* default to async readahead once the per-file window reaches 16MB */
+#define SBI_DEFAULT_RA_ASYNC_THRESHOLD	(16UL << (20 - PAGE_SHIFT))
+
 struct ll_ra_info {
 	atomic_t	ra_cur_pages;
 	unsigned long	ra_max_pages;
 	unsigned long	ra_max_pages_per_file;
 	unsigned long	ra_max_read_ahead_whole_pages;
+	/* per-mount workqueue doing readahead on behalf of readers */
+	struct workqueue_struct *ra_async_wq;
+	/* max number of async readahead works running concurrently */
+	unsigned int	ra_async_max_active;
+	/* window size above which readahead is issued asynchronously */
+	unsigned long	ra_async_pages_per_file_threshold;
+};
+
+/* One asynchronous readahead request, handed to ra_async_wq */
+struct ll_readahead_work {
+	/** file to read ahead, a reference is held until the work is done */
+	struct file		*lrw_file;
+	/** first page index of the readahead window */
+	pgoff_t			 lrw_start;
+	/** last page index of the readahead window */
+	pgoff_t			 lrw_end;
+	/** jobid of the reader that triggered this readahead */
+	char			 lrw_jobid[LUSTRE_JOBID_SIZE];
+	struct work_struct	 lrw_readahead_work;
 };
 
 /* ra_io_arg will be filled in the beginning of ll_readahead with
@@ -557,6 +580,10 @@ struct ll_sb_info {
 	atomic_t		  ll_sa_running; /* running statahead thread
 						  * count */
 	atomic_t		  ll_agl_total;  /* AGL thread started count */
+	atomic_t		  ll_sa_rpc_total; /* statahead getattr RPCs
+						    * sent */
+	atomic_t		  ll_agl_trigger_total; /* AGL glimpses
+							 * triggered */
 
 	dev_t			  ll_sdev_orig; /* save s_dev before assign for
 						 * clustred nfs */
@@ -778,6 +805,8 @@ enum {
 	LPROC_LL_LISTXATTR,
 	LPROC_LL_REMOVEXATTR,
 	LPROC_LL_INODE_PERM,
+	LPROC_LL_RANGE_LOCK_WAIT,
+	LPROC_LL_RANGE_LOCK_HOLD,
 	LPROC_LL_FILE_OPCODES
 };
 
@@ -849,6 +878,7 @@ extern enum ldlm_mode ll_take_md_lock(struct inode *inode, __u64 bits,
 				      enum ldlm_mode mode);
 
 int ll_file_open(struct inode *inode, struct file *file);
+void ll_io_init(struct cl_io *io, struct file *file, enum cl_io_type iot);
 int ll_file_release(struct inode *inode, struct file *file);
 int ll_release_openhandle(struct dentry *, struct lookup_intent *);
 int ll_md_real_close(struct inode *inode, fmode_t fmode);
@@ -100,6 +100,17 @@ static struct ll_sb_info *ll_init_sbi(void)
 					   SBI_DEFAULT_READAHEAD_MAX);
 	sbi->ll_ra_info.ra_max_pages = sbi->ll_ra_info.ra_max_pages_per_file;
 	sbi->ll_ra_info.ra_max_read_ahead_whole_pages = -1;
+	sbi->ll_ra_info.ra_async_max_active = max(num_online_cpus() / 2, 1U);
+	sbi->ll_ra_info.ra_async_pages_per_file_threshold =
+		SBI_DEFAULT_RA_ASYNC_THRESHOLD;
+	sbi->ll_ra_info.ra_async_wq =
+		alloc_workqueue("ll-readahead-wq", WQ_UNBOUND,
+				sbi->ll_ra_info.ra_async_max_active);
+	if (sbi->ll_ra_info.ra_async_wq == NULL) {
+		cl_cache_decref(sbi->ll_cache);
+		OBD_FREE(sbi, sizeof(*sbi));
+		RETURN(NULL);
+	}
 
         ll_generate_random_uuid(uuid);
         class_uuid_unparse(uuid, &sbi->ll_sb_uuid);
@@ -129,6 +140,8 @@ static struct ll_sb_info *ll_init_sbi(void)
 	atomic_set(&sbi->ll_sa_wrong, 0);
 	atomic_set(&sbi->ll_sa_running, 0);
 	atomic_set(&sbi->ll_agl_total, 0);
+	atomic_set(&sbi->ll_sa_rpc_total, 0);
+	atomic_set(&sbi->ll_agl_trigger_total, 0);
 	sbi->ll_flags |= LL_SBI_AGL_ENABLED;
 	sbi->ll_flags |= LL_SBI_FAST_READ;
 	sbi->ll_flags |= LL_SBI_TINY_WRITE;
@@ -150,6 +163,10 @@ static void ll_free_sbi(struct super_block *sb)
 	if (sbi != NULL) {
 		if (!list_empty(&sbi->ll_squash.rsi_nosquash_nids))
 			cfs_free_nidlist(&sbi->ll_squash.rsi_nosquash_nids);
+		if (sbi->ll_ra_info.ra_async_wq != NULL) {
+			destroy_workqueue(sbi->ll_ra_info.ra_async_wq);
+			sbi->ll_ra_info.ra_async_wq = NULL;
+		}
 		if (sbi->ll_cache != NULL) {
 			cl_cache_decref(sbi->ll_cache);
 			sbi->ll_cache = NULL;
@@ -222,7 +239,8 @@ static int client_common_fill_super(struct super_block *sb, char *md, char *dt,
 				   OBD_CONNECT2_LOCK_CONVERT |
 				   OBD_CONNECT2_DIR_MIGRATE |
 				   OBD_CONNECT2_SUM_STATFS |
-				   OBD_CONNECT2_ARCHIVE_ID_ARRAY;
+				   OBD_CONNECT2_ARCHIVE_ID_ARRAY |
+				   OBD_CONNECT2_BL_AST_BATCH;
 
 #ifdef HAVE_LRU_RESIZE_SUPPORT
         if (sbi->ll_flags & LL_SBI_LRU_RESIZE)
@@ -425,7 +443,8 @@ static int client_common_fill_super(struct super_block *sb, char *md, char *dt,
 	data->ocd_connect_flags |= OBD_CONNECT_LOCKAHEAD_OLD;
 #endif
 
-	data->ocd_connect_flags2 = OBD_CONNECT2_LOCKAHEAD;
+	data->ocd_connect_flags2 = OBD_CONNECT2_LOCKAHEAD |
+				   OBD_CONNECT2_BL_AST_BATCH;
 
 	if (!OBD_FAIL_CHECK(OBD_FAIL_OSC_CONNECT_GRANT_PARAM))
 		data->ocd_connect_flags |= OBD_CONNECT_GRANT_PARAM;
@@ -827,10 +827,14 @@ static int ll_statahead_stats_seq_show(struct seq_file *m, void *v)
 
 	seq_printf(m, "statahead total: %u\n"
 		      "statahead wrong: %u\n"
-		      "agl total: %u\n",
+		      "agl total: %u\n"
+		      "statahead rpcs: %u\n"
+		      "agl triggered: %u\n",
 		   atomic_read(&sbi->ll_sa_total),
 		   atomic_read(&sbi->ll_sa_wrong),
-		   atomic_read(&sbi->ll_agl_total));
+		   atomic_read(&sbi->ll_agl_total),
+		   atomic_read(&sbi->ll_sa_rpc_total),
+		   atomic_read(&sbi->ll_agl_trigger_total));
 	return 0;
 }
 
@@ -1013,6 +1017,89 @@ static ssize_t xattr_cache_store(struct kobject *kobj,
 }
 LUSTRE_RW_ATTR(xattr_cache);
 
+static ssize_t max_read_ahead_async_active_show(struct kobject *kobj,
+						struct attribute *attr,
+						char *buf)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+
+	return sprintf(buf, "%u\n", sbi->ll_ra_info.ra_async_max_active);
+}
+
+static ssize_t max_read_ahead_async_active_store(struct kobject *kobj,
+						 struct attribute *attr,
+						 const char *buffer,
+						 size_t count)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+	unsigned int val;
+	int rc;
+
+	rc = kstrtouint(buffer, 10, &val);
+	if (rc)
+		return rc;
+
+	if (val < 1 || val > WQ_UNBOUND_MAX_ACTIVE) {
+		CERROR("Bad max_read_ahead_async_active value %u. Valid values are in the range [1, %d]\n",
+		       val, WQ_UNBOUND_MAX_ACTIVE);
+		return -ERANGE;
+	}
+
+	spin_lock(&sbi->ll_lock);
+	sbi->ll_ra_info.ra_async_max_active = val;
+	spin_unlock(&sbi->ll_lock);
+	workqueue_set_max_active(sbi->ll_ra_info.ra_async_wq, val);
+
+	return count;
+}
+LUSTRE_RW_ATTR(max_read_ahead_async_active);
+
+static ssize_t read_ahead_async_file_threshold_mb_show(struct kobject *kobj,
+						       struct attribute *attr,
+						       char *buf)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+
+	return sprintf(buf, "%lu\n",
+		       sbi->ll_ra_info.ra_async_pages_per_file_threshold >>
+		       (20 - PAGE_SHIFT));
+}
+
+static ssize_t read_ahead_async_file_threshold_mb_store(struct kobject *kobj,
+							struct attribute *attr,
+							const char *buffer,
+							size_t count)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+	unsigned long pages_number;
+	unsigned long max_ra_per_file;
+	int rc;
+
+	rc = kstrtoul(buffer, 10, &pages_number);
+	if (rc)
+		return rc;
+
+	pages_number <<= 20 - PAGE_SHIFT;
+	max_ra_per_file = sbi->ll_ra_info.ra_max_pages_per_file;
+	if (pages_number > max_ra_per_file) {
+		CERROR("Bad read_ahead_async_file_threshold_mb value %lu. Must not exceed max_read_ahead_per_file_mb=%lu\n",
+		       pages_number >> (20 - PAGE_SHIFT),
+		       max_ra_per_file >> (20 - PAGE_SHIFT));
+		return -ERANGE;
+	}
+
+	spin_lock(&sbi->ll_lock);
+	sbi->ll_ra_info.ra_async_pages_per_file_threshold = pages_number;
+	spin_unlock(&sbi->ll_lock);
+
+	return count;
+}
+LUSTRE_RW_ATTR(read_ahead_async_file_threshold_mb);
+
 static ssize_t tiny_write_show(struct kobject *kobj,
 			       struct attribute *attr,
 			       char *buf)
@@ -1291,6 +1378,8 @@ static struct attribute *llite_attrs[] = {
 	&lustre_attr_fast_read.attr,
 	&lustre_attr_pio.attr,
 	&lustre_attr_tiny_write.attr,
+	&lustre_attr_max_read_ahead_async_active.attr,
+	&lustre_attr_read_ahead_async_file_threshold_mb.attr,
 	NULL,
 };
 
@@ -1355,6 +1444,11 @@ static const struct llite_file_opcode {
         { LPROC_LL_LISTXATTR,      LPROCFS_TYPE_REGS, "listxattr" },
         { LPROC_LL_REMOVEXATTR,    LPROCFS_TYPE_REGS, "removexattr" },
         { LPROC_LL_INODE_PERM,     LPROCFS_TYPE_REGS, "inode_permission" },
+	/* range lock serializing writes and direct reads */
+	{ LPROC_LL_RANGE_LOCK_WAIT, LPROCFS_CNTR_AVGMINMAX|LPROCFS_TYPE_USEC,
+				   "range_lock_wait" },
+	{ LPROC_LL_RANGE_LOCK_HOLD, LPROCFS_CNTR_AVGMINMAX|LPROCFS_TYPE_USEC,
+				   "range_lock_hold" },
 };
 
 void ll_stats_ops_tally(struct ll_sb_info *sbi, int op, int count)
@@ -1389,7 +1483,8 @@ static const char *ra_stat_string[] = {
 	[RA_STAT_EOF] = "read-ahead to EOF",
 	[RA_STAT_MAX_IN_FLIGHT] = "hit max r-a issue",
 	[RA_STAT_WRONG_GRAB_PAGE] = "wrong page from grab_cache_page",
-	[RA_STAT_FAILED_REACH_END] = "failed to reach end"
+	[RA_STAT_FAILED_REACH_END] = "failed to reach end",
+	[RA_STAT_ASYNC] = "async readahead",
 };
 
 int ll_debugfs_register_super(struct super_block *sb, const char *name)
@@ -1451,6 +1546,8 @@ int ll_debugfs_register_super(struct super_block *sb, const char *name)
 			ptr = "bytes";
 		else if (type & LPROCFS_TYPE_PAGES)
 			ptr = "pages";
+		else if (type & LPROCFS_TYPE_USEC)
+			ptr = "usec";
 		lprocfs_counter_init(sbi->ll_stats,
 				     llite_opcode_table[id].opcode,
 				     (type & LPROCFS_CNTR_AVGMINMAX),
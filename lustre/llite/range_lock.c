@@ -51,6 +51,7 @@ void range_lock_tree_init(struct range_lock_tree *tree)
 {
 	tree->rlt_root = NULL;
 	tree->rlt_sequence = 0;
+	tree->rlt_waiters = 0;
 	spin_lock_init(&tree->rlt_lock);
 }
 
@@ -162,8 +163,14 @@ void range_unlock(struct range_lock_tree *tree, struct range_lock *lock)
 		interval_erase(&lock->rl_node, &tree->rlt_root);
 	}
 
-	interval_search(tree->rlt_root, &lock->rl_node.in_extent,
-			range_unlock_cb, lock);
+	/*
+	 * A lock queued after this one on an overlapping range is counted in
+	 * rlt_waiters until it is granted, so with no waiters there is nobody
+	 * to wake up and the search can be skipped.
+	 */
+	if (tree->rlt_waiters > 0)
+		interval_search(tree->rlt_root, &lock->rl_node.in_extent,
+				range_unlock_cb, lock);
 	spin_unlock(&tree->rlt_lock);
 
 	EXIT;
@@ -229,17 +236,23 @@ int range_lock(struct range_lock_tree *tree, struct range_lock *lock)
 	}
 	lock->rl_sequence = ++tree->rlt_sequence;
 
-	while (lock->rl_blocking_ranges > 0) {
-		lock->rl_task = current;
-		__set_current_state(TASK_INTERRUPTIBLE);
-		spin_unlock(&tree->rlt_lock);
-		schedule();
+	if (lock->rl_blocking_ranges > 0) {
+		tree->rlt_waiters++;
+		while (lock->rl_blocking_ranges > 0) {
+			lock->rl_task = current;
+			__set_current_state(TASK_INTERRUPTIBLE);
+			spin_unlock(&tree->rlt_lock);
+			schedule();
 
-		if (signal_pending(current)) {
-			range_unlock(tree, lock);
-			GOTO(out, rc = -ERESTARTSYS);
+			spin_lock(&tree->rlt_lock);
+			if (signal_pending(current)) {
+				tree->rlt_waiters--;
+				spin_unlock(&tree->rlt_lock);
+				range_unlock(tree, lock);
+				GOTO(out, rc = -ERESTARTSYS);
+			}
 		}
-		spin_lock(&tree->rlt_lock);
+		tree->rlt_waiters--;
 	}
 	spin_unlock(&tree->rlt_lock);
 out:
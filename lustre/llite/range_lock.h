@@ -78,6 +78,10 @@ struct range_lock_tree {
 	struct interval_node	*rlt_root;
 	spinlock_t		 rlt_lock;
 	__u64			 rlt_sequence;
+	/**
+	 * Number of locks in the tree waiting for an overlapping range
+	 */
+	unsigned int		 rlt_waiters;
 };
 
 void range_lock_tree_init(struct range_lock_tree *tree);
@@ -425,13 +425,257 @@ ll_read_ahead_pages(const struct lu_env *env, struct cl_io *io,
 	return count;
 }
 
+static int ll_readahead_file_kms(const struct lu_env *env,
+				 struct cl_io *io, __u64 *kms)
+{
+	struct cl_object *clob = io->ci_obj;
+	struct cl_attr *attr = vvp_env_thread_attr(env);
+	int rc;
+
+	cl_object_attr_lock(clob);
+	rc = cl_object_attr_get(env, clob, attr);
+	cl_object_attr_unlock(clob);
+
+	if (rc == 0)
+		*kms = attr->cat_kms;
+
+	return rc;
+}
+
+static void ll_readahead_work_free(struct ll_readahead_work *work)
+{
+	fput(work->lrw_file);
+	OBD_FREE_PTR(work);
+}
+
+/**
+ * Read ahead [lrw_start, lrw_end] of a file from the readahead workqueue.
+ *
+ * This mirrors what ll_readahead() does from the reader context, except that
+ * no DLM lock is enqueued here: cl_io_read_ahead() stops the window at the
+ * end of the extent covered by locks the reader already holds, so the work
+ * never blocks on a conflicting lock and never sends an enqueue RPC.
+ */
+static void ll_readahead_handle_work(struct work_struct *wq)
+{
+	struct ll_readahead_work *work;
+	struct ll_readahead_state *ras;
+	struct ll_file_data *fd;
+	struct ll_sb_info *sbi;
+	struct ra_io_arg *ria;
+	struct cl_2queue *queue;
+	struct inode *inode;
+	struct file *file;
+	struct lu_env *env;
+	struct cl_io *io;
+	struct vvp_io *vio;
+	unsigned long end_index;
+	unsigned long len;
+	pgoff_t ra_end = 0;
+	pgoff_t end;
+	__u16 refcheck;
+	__u64 kms;
+	int rc;
+	ENTRY;
+
+	work = container_of(wq, struct ll_readahead_work, lrw_readahead_work);
+	file = work->lrw_file;
+	fd = LUSTRE_FPRIVATE(file);
+	ras = &fd->fd_ras;
+	inode = file_inode(file);
+	sbi = ll_i2sbi(inode);
+	end = work->lrw_end;
+
+	CDEBUG(D_READA, DFID": async ra from %lu to %lu\n",
+	       PFID(ll_inode2fid(inode)), work->lrw_start, work->lrw_end);
+
+	env = cl_env_get(&refcheck);
+	if (IS_ERR(env))
+		GOTO(out_free_work, rc = PTR_ERR(env));
+
+	io = vvp_env_thread_io(env);
+	ll_io_init(io, file, CIT_READ);
+	io->ci_pio = 0;
+
+	rc = ll_readahead_file_kms(env, io, &kms);
+	if (rc != 0)
+		GOTO(out_put_env, rc);
+
+	if (kms == 0) {
+		ll_ra_stats_inc(inode, RA_STAT_ZERO_LEN);
+		GOTO(out_put_env, rc = 0);
+	}
+
+	ria = &ll_env_info(env)->lti_ria;
+	memset(ria, 0, sizeof(*ria));
+	ria->ria_start = work->lrw_start;
+
+	/* Truncate RA window to end of file */
+	end_index = (unsigned long)((kms - 1) >> PAGE_SHIFT);
+	if (end_index <= end) {
+		end = end_index;
+		ria->ria_eof = true;
+	}
+	if (end <= ria->ria_start)
+		GOTO(out_put_env, rc = 0);
+
+	ria->ria_end = end;
+	len = ria->ria_end - ria->ria_start + 1;
+	ria->ria_reserved = ll_ra_count_get(sbi, ria, len, 0);
+	if (ria->ria_reserved < len)
+		ll_ra_stats_inc(inode, RA_STAT_MAX_IN_FLIGHT);
+	if (ria->ria_reserved == 0)
+		GOTO(out_put_env, rc = 0);
+
+	io->ci_async_readahead = 1;
+	rc = cl_io_rw_init(env, io, CIT_READ,
+			   (loff_t)ria->ria_start << PAGE_SHIFT,
+			   len << PAGE_SHIFT);
+	if (rc != 0) {
+		ll_ra_count_put(sbi, ria->ria_reserved);
+		GOTO(out_io_fini, rc);
+	}
+
+	vio = vvp_env_io(env);
+	vio->vui_fd = fd;
+	vio->vui_io_subtype = IO_NORMAL;
+	/* vvp_io_init() stored the jobid of this worker into the inode,
+	 * restore the one of the reader so the RPCs are accounted to it */
+	memcpy(ll_i2info(inode)->lli_jobid, work->lrw_jobid,
+	       sizeof(work->lrw_jobid));
+
+	/* no lock is taken, see the comment above */
+	io->ci_state = CIS_LOCKED;
+	rc = cl_io_start(env, io);
+	if (rc != 0) {
+		ll_ra_count_put(sbi, ria->ria_reserved);
+		GOTO(out_io_end, rc);
+	}
+
+	queue = &io->ci_queue;
+	cl_2queue_init(queue);
+
+	rc = ll_read_ahead_pages(env, io, &queue->c2_qin, ras, ria, &ra_end);
+	if (ria->ria_reserved != 0)
+		ll_ra_count_put(sbi, ria->ria_reserved);
+
+	if (queue->c2_qin.pl_nr > 0) {
+		int count = queue->c2_qin.pl_nr;
+
+		rc = cl_io_submit_rw(env, io, CRT_READ, queue);
+		if (rc == 0)
+			task_io_account_read(PAGE_SIZE * count);
+	}
+
+	if (ra_end == ria->ria_end && ra_end == (kms >> PAGE_SHIFT))
+		ll_ra_stats_inc(inode, RA_STAT_EOF);
+	if (ra_end != ria->ria_end)
+		ll_ra_stats_inc(inode, RA_STAT_FAILED_REACH_END);
+
+	/* TODO: discard all pages until page reinit route is implemented */
+	cl_page_list_discard(env, io, &queue->c2_qin);
+
+	/* Unlock unsent read pages in case of error. */
+	cl_page_list_disown(env, io, &queue->c2_qin);
+
+	cl_2queue_fini(env, queue);
+out_io_end:
+	cl_io_end(env, io);
+out_io_fini:
+	cl_io_fini(env, io);
+out_put_env:
+	cl_env_put(env, &refcheck);
+out_free_work:
+	/* kickoff_async_readahead() moved ras_next_readahead past this
+	 * window, give back the part that could not be read so that the
+	 * reader picks it up from ll_readahead() */
+	spin_lock(&ras->ras_lock);
+	if (ras->ras_next_readahead == work->lrw_end + 1 &&
+	    ra_end < work->lrw_end)
+		ras->ras_next_readahead = ra_end > work->lrw_start ?
+					  ra_end + 1 : work->lrw_start;
+	spin_unlock(&ras->ras_lock);
+
+	if (ra_end > 0)
+		ll_ra_stats_inc_sbi(sbi, RA_STAT_ASYNC);
+	ll_readahead_work_free(work);
+	EXIT;
+}
+
+/**
+ * Hand the next readahead window of a sequential stream to the per-mount
+ * readahead workqueue, so that the reader is not the one building and
+ * sending it when it runs out of readahead pages.
+ *
+ * Called with the page being read locked, so it must not block.
+ *
+ * \retval 1 async readahead was queued, or is not needed yet
+ * \retval 0 the reader should do readahead by itself
+ */
+static int kickoff_async_readahead(struct file *file)
+{
+	struct inode *inode = file_inode(file);
+	struct ll_sb_info *sbi = ll_i2sbi(inode);
+	struct ll_ra_info *ra = &sbi->ll_ra_info;
+	struct ll_file_data *fd = LUSTRE_FPRIVATE(file);
+	struct ll_readahead_state *ras = &fd->fd_ras;
+	struct ll_readahead_work *lrw;
+	unsigned long threshold;
+	pgoff_t start;
+	pgoff_t end;
+
+	threshold = min(ra->ra_async_pages_per_file_threshold,
+			ra->ra_max_pages_per_file);
+	if (ra->ra_async_wq == NULL || threshold == 0)
+		return 0;
+
+	/* Stride readahead and short windows are left to ll_readahead(),
+	 * they don't read enough to be worth a context switch. */
+	spin_lock(&ras->ras_lock);
+	if (stride_io_mode(ras) || ras->ras_window_len < threshold) {
+		spin_unlock(&ras->ras_lock);
+		return 0;
+	}
+	start = ras->ras_next_readahead;
+	end = start + ras->ras_window_len - 1;
+	spin_unlock(&ras->ras_lock);
+
+	if (atomic_read(&ra->ra_cur_pages) + ras->ras_window_len >
+	    ra->ra_max_pages)
+		return 0;
+
+	/* ll_readahead_work_free() frees it */
+	OBD_ALLOC_PTR(lrw);
+	if (lrw == NULL)
+		return 0;
+
+	spin_lock(&ras->ras_lock);
+	if (ras->ras_next_readahead != start) {
+		/* raced with another reader of this file descriptor */
+		spin_unlock(&ras->ras_lock);
+		OBD_FREE_PTR(lrw);
+		return 1;
+	}
+	ras->ras_next_readahead = end + 1;
+	spin_unlock(&ras->ras_lock);
+
+	lrw->lrw_file = get_file(file);
+	lrw->lrw_start = start;
+	lrw->lrw_end = end;
+	memcpy(lrw->lrw_jobid, ll_i2info(inode)->lli_jobid,
+	       sizeof(lrw->lrw_jobid));
+	INIT_WORK(&lrw->lrw_readahead_work, ll_readahead_handle_work);
+	queue_work(ra->ra_async_wq, &lrw->lrw_readahead_work);
+
+	return 1;
+}
+
 static int ll_readahead(const struct lu_env *env, struct cl_io *io,
 			struct cl_page_list *queue,
 			struct ll_readahead_state *ras, bool hit)
 {
 	struct vvp_io *vio = vvp_env_io(env);
 	struct ll_thread_info *lti = ll_env_info(env);
-	struct cl_attr *attr = vvp_env_thread_attr(env);
 	unsigned long len, mlen = 0;
 	pgoff_t ra_end = 0, start = 0, end = 0;
 	struct inode *inode;
@@ -446,13 +690,10 @@ static int ll_readahead(const struct lu_env *env, struct cl_io *io,
 
 	memset(ria, 0, sizeof *ria);
 
-	cl_object_attr_lock(clob);
-	ret = cl_object_attr_get(env, clob, attr);
-	cl_object_attr_unlock(clob);
-
+	ret = ll_readahead_file_kms(env, io, &kms);
 	if (ret != 0)
 		RETURN(ret);
-	kms = attr->cat_kms;
+
 	if (kms == 0) {
 		ll_ra_stats_inc(inode, RA_STAT_ZERO_LEN);
 		RETURN(0);
@@ -1224,7 +1465,8 @@ int ll_readpage(struct file *file, struct page *vmpage)
 			 * the case, we can't do fast IO because we will need
 			 * a cl_io to issue the RPC. */
 			if (ras->ras_window_start + ras->ras_window_len <
-			    ras->ras_next_readahead + PTLRPC_MAX_BRW_PAGES) {
+			    ras->ras_next_readahead + PTLRPC_MAX_BRW_PAGES ||
+			    kickoff_async_readahead(file) > 0) {
 				/* export the page and skip io stack */
 				vpg->vpg_ra_used = 1;
 				cl_page_export(env, page, 1);
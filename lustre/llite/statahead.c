@@ -603,7 +603,9 @@ static void ll_agl_trigger(struct inode *inode, struct ll_statahead_info *sai)
         CDEBUG(D_READA, "Handling (init) async glimpse: inode = "
 	       DFID", idx = %llu\n", PFID(&lli->lli_fid), index);
 
-        cl_agl(inode);
+	/* may be served by a cached lock without a glimpse RPC */
+	if (cl_agl(inode) == 0)
+		atomic_inc(&ll_i2sbi(inode)->ll_agl_trigger_total);
         lli->lli_agl_index = 0;
 	lli->lli_glimpse_time = ktime_get();
 	up_write(&lli->lli_glimpse_sem);
@@ -868,10 +870,12 @@ static void sa_statahead(struct dentry *parent, const char *name, int len,
 	if (dentry != NULL)
 		dput(dentry);
 
-	if (rc != 0)
+	if (rc != 0) {
 		sa_make_ready(sai, entry, rc);
-	else
+	} else {
 		sai->sai_sent++;
+		atomic_inc(&ll_i2sbi(dir)->ll_sa_rpc_total);
+	}
 
 	sai->sai_index++;
 
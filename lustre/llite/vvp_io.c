@@ -777,6 +777,11 @@ static int vvp_io_read_start(const struct lu_env *env,
 	if (vio->vui_io_subtype == IO_NORMAL)
 		down_read(&lli->lli_trunc_sem);
 
+	/* async readahead only needs lli_trunc_sem to be held against
+	 * truncate, pages are read by ll_readahead_handle_work() */
+	if (io->ci_async_readahead)
+		RETURN(0);
+
 	if (!can_populate_pages(env, io, inode))
 		RETURN(0);
 
@@ -839,8 +839,15 @@ static int lov_io_rw_iter_init(const struct lu_env *env,
 
 	lse = lov_lse(lio->lis_object, index);
 
+	/*
+	 * Direct IO is not split at stripe boundaries: the whole range of
+	 * the component is handled in one iteration, so that the pages of
+	 * all stripes are submitted together and the BRW RPCs to different
+	 * OSTs are in flight at the same time, instead of waiting for each
+	 * stripe in turn.
+	 */
 	next = MAX_LFS_FILESIZE;
-	if (lse->lsme_stripe_count > 1) {
+	if (lse->lsme_stripe_count > 1 && !cl_io_is_direct(io)) {
 		unsigned long ssize = lse->lsme_stripe_size;
 
 		lov_do_div64(start, ssize);
@@ -873,8 +880,9 @@ static int lov_io_rw_iter_init(const struct lu_env *env,
 		RETURN(0);
 
 	/*
-	 * XXX The following call should be optimized: we know, that
-	 * [lio->lis_pos, lio->lis_endpos) intersects with exactly one stripe.
+	 * XXX The following call should be optimized: unless this is a
+	 * direct IO, we know that [lio->lis_pos, lio->lis_endpos) intersects
+	 * with exactly one stripe.
 	 */
 	RETURN(lov_io_iter_init(env, ios));
 }
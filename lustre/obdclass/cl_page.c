@@ -47,6 +47,19 @@
 
 static void cl_page_delete0(const struct lu_env *env, struct cl_page *pg);
 
+/*
+ * cl_page together with all its slices is allocated as one buffer whose size
+ * (cl_object_header::coh_page_bufsize) depends on the layers of the object.
+ * Only a few distinct sizes are in use at any time (typically one per layout
+ * type), so each size gets its own slab cache, created on first use. This
+ * lets cl_page allocation and freeing use the per-CPU slab caches instead of
+ * going through generic kmalloc buckets for every page.
+ */
+#define CL_PAGE_KMEM_ARRAY_SIZE	16
+static struct kmem_cache *cl_page_kmem_array[CL_PAGE_KMEM_ARRAY_SIZE];
+static unsigned short cl_page_kmem_size_array[CL_PAGE_KMEM_ARRAY_SIZE];
+static DEFINE_MUTEX(cl_page_kmem_mutex);
+
 #ifdef LIBCFS_DEBUG
 # define PASSERT(env, page, expr)                                       \
   do {                                                                    \
@@ -167,7 +180,11 @@ static void cl_page_free(const struct lu_env *env, struct cl_page *page,
 	lu_object_ref_del_at(&obj->co_lu, &page->cp_obj_ref, "cl_page", page);
 	cl_object_put(env, obj);
 	lu_ref_fini(&page->cp_reference);
-	OBD_FREE(page, pagesize);
+	if (page->cp_kmem_index >= 0)
+		OBD_SLAB_FREE(page, cl_page_kmem_array[page->cp_kmem_index],
+			      pagesize);
+	else
+		OBD_FREE(page, pagesize);
 	EXIT;
 }
 
@@ -182,6 +199,73 @@ static inline void cl_page_state_set_trust(struct cl_page *page,
         *(enum cl_page_state *)&page->cp_state = state;
 }
 
+static struct cl_page *__cl_page_alloc(struct cl_object *o)
+{
+	unsigned short bufsize = cl_object_header(o)->coh_page_bufsize;
+	struct cl_page *page = NULL;
+	int i = 0;
+
+check:
+	/* only a handful of entries are expected, so a linear scan is cheap */
+	for (; i < ARRAY_SIZE(cl_page_kmem_array); i++) {
+		if (smp_load_acquire(&cl_page_kmem_size_array[i]) == bufsize) {
+			OBD_SLAB_ALLOC_GFP(page, cl_page_kmem_array[i],
+					   bufsize, GFP_NOFS);
+			if (page != NULL)
+				page->cp_kmem_index = i;
+			return page;
+		}
+		if (cl_page_kmem_size_array[i] == 0)
+			break;
+	}
+
+	if (i < ARRAY_SIZE(cl_page_kmem_array)) {
+		char cache_name[32];
+
+		mutex_lock(&cl_page_kmem_mutex);
+		if (cl_page_kmem_size_array[i] != 0) {
+			/* raced with another thread creating this entry */
+			mutex_unlock(&cl_page_kmem_mutex);
+			goto check;
+		}
+		snprintf(cache_name, sizeof(cache_name), "cl_page_kmem-%u",
+			 bufsize);
+		cl_page_kmem_array[i] = kmem_cache_create(cache_name, bufsize,
+							  0, 0, NULL);
+		if (cl_page_kmem_array[i] == NULL) {
+			mutex_unlock(&cl_page_kmem_mutex);
+			return NULL;
+		}
+		smp_store_release(&cl_page_kmem_size_array[i], bufsize);
+		mutex_unlock(&cl_page_kmem_mutex);
+		goto check;
+	}
+
+	/* all slots are taken, fall back to kmalloc */
+	OBD_ALLOC_GFP(page, bufsize, GFP_NOFS);
+	if (page != NULL)
+		page->cp_kmem_index = -1;
+
+	return page;
+}
+
+/**
+ * Destroy the slab caches created by __cl_page_alloc(). Called at module
+ * unload, when all cl_pages are gone.
+ */
+void cl_page_kmem_fini(void)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(cl_page_kmem_array); i++) {
+		if (cl_page_kmem_size_array[i] == 0)
+			break;
+		kmem_cache_destroy(cl_page_kmem_array[i]);
+		cl_page_kmem_array[i] = NULL;
+		cl_page_kmem_size_array[i] = 0;
+	}
+}
+
 struct cl_page *cl_page_alloc(const struct lu_env *env,
 		struct cl_object *o, pgoff_t ind, struct page *vmpage,
 		enum cl_page_type type)
@@ -190,8 +274,7 @@ struct cl_page *cl_page_alloc(const struct lu_env *env,
 	struct lu_object_header *head;
 
 	ENTRY;
-	OBD_ALLOC_GFP(page, cl_object_header(o)->coh_page_bufsize,
-			GFP_NOFS);
+	page = __cl_page_alloc(o);
 	if (page != NULL) {
 		int result = 0;
 		atomic_set(&page->cp_ref, 1);
@@ -782,6 +782,7 @@ static const char *obd_connect_names[] = {
 	"wbc",		/* 0x40 */
 	"lock_convert",  /* 0x80 */
 	"archive_id_array",	/* 0x100 */
+	"bl_ast_batch",	/* 0x200 */
 	NULL
 };
 
@@ -137,6 +137,50 @@ static ssize_t max_rpcs_in_flight_store(struct kobject *kobj,
 }
 LUSTRE_RW_ATTR(max_rpcs_in_flight);
 
+static ssize_t adaptive_rpcs_in_flight_show(struct kobject *kobj,
+					    struct attribute *attr,
+					    char *buf)
+{
+	struct obd_device *dev = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	struct client_obd *cli = &dev->u.cli;
+
+	return sprintf(buf, "%u\n", cli->cl_rpc_window != 0);
+}
+
+static ssize_t adaptive_rpcs_in_flight_store(struct kobject *kobj,
+					     struct attribute *attr,
+					     const char *buffer,
+					     size_t count)
+{
+	struct obd_device *dev = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	struct client_obd *cli = &dev->u.cli;
+	bool val;
+	int rc;
+
+	rc = kstrtobool(buffer, &val);
+	if (rc)
+		return rc;
+
+	spin_lock(&cli->cl_loi_list_lock);
+	if (val && cli->cl_rpc_window == 0) {
+		/* start from half of the static limit and probe from there */
+		cli->cl_rpc_window = max_t(u32,
+					   cli->cl_max_rpcs_in_flight / 2, 1);
+		cli->cl_rpc_window_acks = 0;
+		cli->cl_rpc_window_rounds = 0;
+		cli->cl_rpc_rtt_min_us = 0;
+		cli->cl_rpc_rtt_avg_us = 0;
+	} else if (!val) {
+		cli->cl_rpc_window = 0;
+	}
+	spin_unlock(&cli->cl_loi_list_lock);
+
+	return count;
+}
+LUSTRE_RW_ATTR(adaptive_rpcs_in_flight);
+
 static ssize_t max_dirty_mb_show(struct kobject *kobj,
 				 struct attribute *attr,
 				 char *buf)
@@ -271,6 +315,18 @@ static ssize_t cur_dirty_bytes_show(struct kobject *kobj,
 }
 LUSTRE_RO_ATTR(cur_dirty_bytes);
 
+static ssize_t write_bandwidth_kbps_show(struct kobject *kobj,
+					 struct attribute *attr,
+					 char *buf)
+{
+	struct obd_device *dev = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	struct client_obd *cli = &dev->u.cli;
+
+	return sprintf(buf, "%lu\n", READ_ONCE(cli->cl_write_bw));
+}
+LUSTRE_RO_ATTR(write_bandwidth_kbps);
+
 static int osc_cur_grant_bytes_seq_show(struct seq_file *m, void *v)
 {
 	struct obd_device *dev = m->private;
@@ -609,6 +665,28 @@ static int osc_unstable_stats_seq_show(struct seq_file *m, void *v)
 }
 LPROC_SEQ_FOPS_RO(osc_unstable_stats);
 
+static int osc_rpc_window_seq_show(struct seq_file *m, void *v)
+{
+	struct obd_device *dev = m->private;
+	struct client_obd *cli = &dev->u.cli;
+	u32 window;
+	u64 rtt_min;
+	u64 rtt_avg;
+
+	spin_lock(&cli->cl_loi_list_lock);
+	window = cli->cl_rpc_window ?: cli->cl_max_rpcs_in_flight;
+	rtt_min = cli->cl_rpc_rtt_min_us;
+	rtt_avg = cli->cl_rpc_rtt_avg_us;
+	spin_unlock(&cli->cl_loi_list_lock);
+
+	seq_printf(m, "window: %u\n"
+		      "rtt_min_us: %llu\n"
+		      "rtt_avg_us: %llu\n",
+		   window, rtt_min, rtt_avg);
+	return 0;
+}
+LPROC_SEQ_FOPS_RO(osc_rpc_window);
+
 static ssize_t idle_timeout_show(struct kobject *kobj, struct attribute *attr,
 				 char *buf)
 {
@@ -778,6 +856,8 @@ struct lprocfs_vars lprocfs_osc_obd_vars[] = {
 	  .fops	=	&osc_pinger_recov_fops		},
 	{ .name	=	"unstable_stats",
 	  .fops	=	&osc_unstable_stats_fops	},
+	{ .name	=	"rpc_window",
+	  .fops	=	&osc_rpc_window_fops		},
 	{ NULL }
 };
 
@@ -949,6 +1029,7 @@ int lprocfs_osc_attach_seqstat(struct obd_device *dev)
 
 static struct attribute *osc_attrs[] = {
 	&lustre_attr_active.attr,
+	&lustre_attr_adaptive_rpcs_in_flight.attr,
 	&lustre_attr_checksums.attr,
 	&lustre_attr_checksum_dump.attr,
 	&lustre_attr_contention_seconds.attr,
@@ -967,6 +1048,7 @@ static struct attribute *osc_attrs[] = {
 	&lustre_attr_idle_timeout.attr,
 	&lustre_attr_idle_connect.attr,
 	&lustre_attr_grant_shrink.attr,
+	&lustre_attr_write_bandwidth_kbps.attr,
 	NULL,
 };
 
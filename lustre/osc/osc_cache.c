@@ -43,6 +43,10 @@
 
 static int extent_debug; /* set it to be true for more debug */
 
+/* split the dirty cache among OSCs by write bandwidth, see osc_dirty_budget() */
+static unsigned int osc_dirty_balance;
+module_param(osc_dirty_balance, uint, 0644);
+
 static void osc_update_pending(struct osc_object *obj, int cmd, int delta);
 static int osc_extent_wait(const struct lu_env *env, struct osc_extent *ext,
 			   enum osc_extent_state state);
@@ -1526,6 +1530,146 @@ static void osc_exit_cache(struct client_obd *cli, struct osc_async_page *oap)
 	spin_unlock(&cli->cl_loi_list_lock);
 }
 
+/*
+ * Dirty cache budget by drain bandwidth.
+ *
+ * Each OSC measures the rate at which its dirty pages are written out to the
+ * OST. Once the dirty cache of the client is under pressure, every OSC may only
+ * hold a share of obd_max_dirty_pages proportional to its share of the total
+ * drain bandwidth, so that a slow OST cannot fill up the whole cache and stall
+ * the writers to the fast ones. An OSC always keeps enough dirty pages to fill
+ * its RPC pipeline, and never more than its own max_dirty_mb.
+ */
+#define OSC_WRITE_BW_INTERVAL_MS	200
+#define OSC_WRITE_BW_IDLE_MS		(10 * OSC_WRITE_BW_INTERVAL_MS)
+
+/* protects cl_write_bw and cl_write_bw_list of all OSCs */
+static DEFINE_SPINLOCK(osc_write_bw_lock);
+/* OSCs with a non-zero cl_write_bw */
+static LIST_HEAD(osc_write_bw_list);
+/* last time idle OSCs were dropped from osc_write_bw_list */
+static ktime_t osc_write_bw_expired;
+/* total write bandwidth of all OSCs in KiB/s */
+static atomic_long_t osc_write_bw_total = ATOMIC_LONG_INIT(0);
+
+/* caller must hold osc_write_bw_lock */
+static void osc_write_bw_set(struct client_obd *cli, unsigned long bw)
+{
+	assert_spin_locked(&osc_write_bw_lock);
+
+	atomic_long_add((long)bw - (long)cli->cl_write_bw,
+			&osc_write_bw_total);
+	WRITE_ONCE(cli->cl_write_bw, bw);
+	if (bw == 0)
+		list_del_init(&cli->cl_write_bw_list);
+	else if (list_empty(&cli->cl_write_bw_list))
+		list_add_tail(&cli->cl_write_bw_list, &osc_write_bw_list);
+}
+
+static bool osc_write_bw_idle(struct client_obd *cli, ktime_t now)
+{
+	return ktime_ms_delta(now, READ_ONCE(cli->cl_write_bw_stamp)) >
+	       OSC_WRITE_BW_IDLE_MS;
+}
+
+/*
+ * cl_write_bw only changes when a write RPC completes, so an OSC which went
+ * idle would keep its last bandwidth in the total forever and shrink the share
+ * of the active ones. Drop the bandwidth of OSCs idle for longer than
+ * OSC_WRITE_BW_IDLE_MS, at most once per OSC_WRITE_BW_INTERVAL_MS.
+ */
+static void osc_write_bw_expire(ktime_t now)
+{
+	struct client_obd *cli;
+	struct client_obd *tmp;
+
+	if (ktime_ms_delta(now, READ_ONCE(osc_write_bw_expired)) <
+	    OSC_WRITE_BW_INTERVAL_MS)
+		return;
+
+	spin_lock(&osc_write_bw_lock);
+	osc_write_bw_expired = now;
+	list_for_each_entry_safe(cli, tmp, &osc_write_bw_list,
+				 cl_write_bw_list) {
+		if (osc_write_bw_idle(cli, now))
+			osc_write_bw_set(cli, 0);
+	}
+	spin_unlock(&osc_write_bw_lock);
+}
+
+/* caller must hold loi_list_lock */
+void osc_write_bw_update(struct client_obd *cli, unsigned long bytes)
+{
+	ktime_t now = ktime_get();
+	unsigned long bw;
+	s64 ms;
+
+	assert_spin_locked(&cli->cl_loi_list_lock);
+
+	cli->cl_write_bw_bytes += bytes;
+	ms = ktime_ms_delta(now, cli->cl_write_bw_stamp);
+	if (ms < OSC_WRITE_BW_INTERVAL_MS)
+		return;
+
+	/* a long idle period would underestimate the bandwidth, start a new
+	 * measurement interval instead, the old value is stale by now */
+	spin_lock(&osc_write_bw_lock);
+	if (ms <= OSC_WRITE_BW_IDLE_MS) {
+		bw = div64_u64(cli->cl_write_bw_bytes * MSEC_PER_SEC,
+			       ms << 10);
+		if (cli->cl_write_bw != 0)
+			bw = (cli->cl_write_bw * 3 + bw) / 4;
+		osc_write_bw_set(cli, max(bw, 1UL));
+	} else {
+		osc_write_bw_set(cli, 0);
+	}
+	spin_unlock(&osc_write_bw_lock);
+	cli->cl_write_bw_bytes = 0;
+	WRITE_ONCE(cli->cl_write_bw_stamp, now);
+
+	osc_write_bw_expire(now);
+}
+
+void osc_write_bw_fini(struct client_obd *cli)
+{
+	spin_lock(&osc_write_bw_lock);
+	osc_write_bw_set(cli, 0);
+	spin_unlock(&osc_write_bw_lock);
+}
+
+/* caller must hold loi_list_lock */
+static unsigned long osc_dirty_budget(struct client_obd *cli)
+{
+	unsigned long budget = cli->cl_dirty_max_pages;
+	unsigned long bw = READ_ONCE(cli->cl_write_bw);
+	unsigned long total;
+	unsigned long floor;
+	ktime_t now;
+	u64 share;
+
+	if (!osc_dirty_balance || bw == 0)
+		return budget;
+
+	if (atomic_long_read(&obd_dirty_pages) < obd_max_dirty_pages / 2)
+		return budget;
+
+	/* skip the bandwidth of idle OSCs, including this one */
+	now = ktime_get();
+	osc_write_bw_expire(now);
+	if (osc_write_bw_idle(cli, now))
+		return budget;
+
+	total = atomic_long_read(&osc_write_bw_total);
+	if (total <= bw)
+		return budget;
+
+	share = div64_u64((u64)obd_max_dirty_pages * bw, total);
+	floor = min_t(unsigned long, budget, cli->cl_max_pages_per_rpc *
+					     cli->cl_max_rpcs_in_flight);
+
+	return clamp_t(u64, share, floor, budget);
+}
+
 /**
  * Non-blocking version of osc_enter_cache() that consumes grant only when it
  * is available.
@@ -1542,7 +1686,7 @@ static int osc_enter_cache_try(struct client_obd *cli,
 	if (rc < 0)
 		return 0;
 
-	if (cli->cl_dirty_pages < cli->cl_dirty_max_pages &&
+	if (cli->cl_dirty_pages < osc_dirty_budget(cli) &&
 	    1 + atomic_long_read(&obd_dirty_pages) <= obd_max_dirty_pages) {
 		osc_consume_write_grant(cli, &oap->oap_brw_page);
 		if (transient) {
@@ -1685,18 +1829,21 @@ void osc_wake_cache_waiters(struct client_obd *cli)
 
 	ENTRY;
 	list_for_each_safe(l, tmp, &cli->cl_cache_waiters) {
+		unsigned long budget;
+
 		ocw = list_entry(l, struct osc_cache_waiter, ocw_entry);
 		list_del_init(&ocw->ocw_entry);
 
 		ocw->ocw_rc = -EDQUOT;
 		/* we can't dirty more */
-		if ((cli->cl_dirty_pages  >= cli->cl_dirty_max_pages) ||
+		budget = osc_dirty_budget(cli);
+		if ((cli->cl_dirty_pages  >= budget) ||
 		    (1 + atomic_long_read(&obd_dirty_pages) >
 		     obd_max_dirty_pages)) {
 			CDEBUG(D_CACHE, "no dirty room: dirty: %ld "
-			       "osc max %ld, sys max %ld\n",
+			       "osc max %ld, osc budget %ld, sys max %ld\n",
 			       cli->cl_dirty_pages, cli->cl_dirty_max_pages,
-			       obd_max_dirty_pages);
+			       budget, obd_max_dirty_pages);
 			goto wakeup;
 		}
 
@@ -1716,7 +1863,9 @@ EXPORT_SYMBOL(osc_wake_cache_waiters);
 static int osc_max_rpc_in_flight(struct client_obd *cli, struct osc_object *osc)
 {
 	int hprpc = !!list_empty(&osc->oo_hp_exts);
-	return rpcs_in_flight(cli) >= cli->cl_max_rpcs_in_flight + hprpc;
+	u32 max_rpcs = cli->cl_rpc_window ?: cli->cl_max_rpcs_in_flight;
+
+	return rpcs_in_flight(cli) >= max_rpcs + hprpc;
 }
 
 /* This maintains the lists of pending pages to read/write for a given object
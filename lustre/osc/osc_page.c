@@ -362,6 +362,23 @@ void osc_page_submit(const struct lu_env *env, struct osc_page *opg,
 
 static DECLARE_WAIT_QUEUE_HEAD(osc_lru_waitq);
 
+/**
+ * LRU slots are returned for every page freed from the cache, so avoid taking
+ * the lock of the global wait queue unless somebody is actually waiting for
+ * a slot. The caller has just updated cl_lru_left.
+ */
+static inline void osc_lru_wakeup(bool all)
+{
+	smp_mb__after_atomic();
+	if (!waitqueue_active(&osc_lru_waitq))
+		return;
+
+	if (all)
+		wake_up_all(&osc_lru_waitq);
+	else
+		wake_up(&osc_lru_waitq);
+}
+
 /**
  * LRU pages are freed in batch mode. OSC should at least free this
  * number of pages to avoid running out of LRU slots.
@@ -441,9 +458,36 @@ int lru_queue_work(const struct lu_env *env, void *data)
 	RETURN(0);
 }
 
+/**
+ * Lock the LRU shard of \a opg. A re-add may move the page to another shard
+ * until the lock is held, so check the shard again after taking it.
+ */
+static struct cl_lru_shard *osc_lru_lock(struct client_obd *cli,
+					 struct osc_page *opg)
+{
+	struct cl_lru_shard *shard;
+	unsigned int idx;
+
+	while (1) {
+		idx = READ_ONCE(opg->ops_lru_shard);
+		shard = &cli->cl_lru_shards[idx];
+		spin_lock(&shard->cls_lock);
+		if (likely(opg->ops_lru_shard == idx))
+			return shard;
+		spin_unlock(&shard->cls_lock);
+	}
+}
+
+/**
+ * Pages are added to the LRU shard of the current CPU, so that threads
+ * completing I/O on different CPUs don't contend on the same list lock. The
+ * LRU order is kept within a shard only, which is good enough for reclaim.
+ */
 void osc_lru_add_batch(struct client_obd *cli, struct list_head *plist)
 {
 	struct list_head lru = LIST_HEAD_INIT(lru);
+	unsigned int idx = raw_smp_processor_id() % CL_LRU_SHARDS;
+	struct cl_lru_shard *shard = &cli->cl_lru_shards[idx];
 	struct osc_async_page *oap;
 	long npages = 0;
 
@@ -459,12 +503,16 @@ void osc_lru_add_batch(struct client_obd *cli, struct list_head *plist)
 	}
 
 	if (npages > 0) {
-		spin_lock(&cli->cl_lru_list_lock);
-		list_splice_tail(&lru, &cli->cl_lru_list);
+		struct osc_page *opg;
+
+		spin_lock(&shard->cls_lock);
+		list_for_each_entry(opg, &lru, ops_lru)
+			WRITE_ONCE(opg->ops_lru_shard, idx);
+		list_splice_tail(&lru, &shard->cls_list);
 		atomic_long_sub(npages, &cli->cl_lru_busy);
 		atomic_long_add(npages, &cli->cl_lru_in_list);
 		cli->cl_lru_last_used = ktime_get_real_seconds();
-		spin_unlock(&cli->cl_lru_list_lock);
+		spin_unlock(&shard->cls_lock);
 
 		if (waitqueue_active(&osc_lru_waitq))
 			(void)ptlrpcd_queue_work(cli->cl_lru_work);
@@ -485,14 +533,15 @@ static void __osc_lru_del(struct client_obd *cli, struct osc_page *opg)
 static void osc_lru_del(struct client_obd *cli, struct osc_page *opg)
 {
 	if (opg->ops_in_lru) {
-		spin_lock(&cli->cl_lru_list_lock);
+		struct cl_lru_shard *shard = osc_lru_lock(cli, opg);
+
 		if (!list_empty(&opg->ops_lru)) {
 			__osc_lru_del(cli, opg);
 		} else {
 			LASSERT(atomic_long_read(&cli->cl_lru_busy) > 0);
 			atomic_long_dec(&cli->cl_lru_busy);
 		}
-		spin_unlock(&cli->cl_lru_list_lock);
+		spin_unlock(&shard->cls_lock);
 
 		atomic_long_inc(cli->cl_lru_left);
 		/* this is a great place to release more LRU pages if
@@ -502,7 +551,7 @@ static void osc_lru_del(struct client_obd *cli, struct osc_page *opg)
 			CDEBUG(D_CACHE, "%s: queue LRU work\n", cli_name(cli));
 			(void)ptlrpcd_queue_work(cli->cl_lru_work);
 		}
-		wake_up(&osc_lru_waitq);
+		osc_lru_wakeup(false);
 	} else {
 		LASSERT(list_empty(&opg->ops_lru));
 	}
@@ -516,12 +565,13 @@ static void osc_lru_use(struct client_obd *cli, struct osc_page *opg)
 	/* If page is being transferred for the first time,
 	 * ops_lru should be empty */
 	if (opg->ops_in_lru) {
-		spin_lock(&cli->cl_lru_list_lock);
+		struct cl_lru_shard *shard = osc_lru_lock(cli, opg);
+
 		if (!list_empty(&opg->ops_lru)) {
 			__osc_lru_del(cli, opg);
 			atomic_long_inc(&cli->cl_lru_busy);
 		}
-		spin_unlock(&cli->cl_lru_list_lock);
+		spin_unlock(&shard->cls_lock);
 	}
 }
 
@@ -577,11 +627,14 @@ long osc_lru_shrink(const struct lu_env *env, struct client_obd *cli,
 	struct cl_io *io;
 	struct cl_object *clobj = NULL;
 	struct cl_page **pvec;
+	struct cl_lru_shard *shard;
 	struct osc_page *opg;
 	long count = 0;
 	int maxscan = 0;
 	int index = 0;
 	int rc = 0;
+	unsigned int first;
+	int i;
 	ENTRY;
 
 	LASSERT(atomic_long_read(&cli->cl_lru_in_list) >= 0);
@@ -605,91 +658,102 @@ long osc_lru_shrink(const struct lu_env *env, struct client_obd *cli,
 	pvec = (struct cl_page **)osc_env_info(env)->oti_pvec;
 	io = osc_env_thread_io(env);
 
-	spin_lock(&cli->cl_lru_list_lock);
 	if (force)
 		cli->cl_lru_reclaim++;
 	maxscan = min(target << 1, atomic_long_read(&cli->cl_lru_in_list));
-	while (!list_empty(&cli->cl_lru_list)) {
-		struct cl_page *page;
-		bool will_free = false;
+	/* start with a different shard every time to age them evenly */
+	first = atomic_inc_return(&cli->cl_lru_shard_next);
+	for (i = 0; i < CL_LRU_SHARDS; i++) {
+		shard = &cli->cl_lru_shards[(first + i) % CL_LRU_SHARDS];
 
-		if (!force && atomic_read(&cli->cl_lru_shrinkers) > 1)
-			break;
+		spin_lock(&shard->cls_lock);
+		while (!list_empty(&shard->cls_list)) {
+			struct cl_page *page;
+			bool will_free = false;
 
-		if (--maxscan < 0)
-			break;
+			if (!force && atomic_read(&cli->cl_lru_shrinkers) > 1)
+				break;
 
-		opg = list_entry(cli->cl_lru_list.next, struct osc_page,
-				 ops_lru);
-		page = opg->ops_cl.cpl_page;
-		if (lru_page_busy(cli, page)) {
-			list_move_tail(&opg->ops_lru, &cli->cl_lru_list);
-			continue;
-		}
+			if (--maxscan < 0)
+				break;
 
-		LASSERT(page->cp_obj != NULL);
-		if (clobj != page->cp_obj) {
-			struct cl_object *tmp = page->cp_obj;
+			opg = list_entry(shard->cls_list.next, struct osc_page,
+					 ops_lru);
+			page = opg->ops_cl.cpl_page;
+			if (lru_page_busy(cli, page)) {
+				list_move_tail(&opg->ops_lru, &shard->cls_list);
+				continue;
+			}
 
-			cl_object_get(tmp);
-			spin_unlock(&cli->cl_lru_list_lock);
+			LASSERT(page->cp_obj != NULL);
+			if (clobj != page->cp_obj) {
+				struct cl_object *tmp = page->cp_obj;
 
-			if (clobj != NULL) {
-				discard_pagevec(env, io, pvec, index);
-				index = 0;
+				cl_object_get(tmp);
+				spin_unlock(&shard->cls_lock);
 
-				cl_io_fini(env, io);
-				cl_object_put(env, clobj);
-				clobj = NULL;
-			}
+				if (clobj != NULL) {
+					discard_pagevec(env, io, pvec, index);
+					index = 0;
 
-			clobj = tmp;
-			io->ci_obj = clobj;
-			io->ci_ignore_layout = 1;
-			rc = cl_io_init(env, io, CIT_MISC, clobj);
+					cl_io_fini(env, io);
+					cl_object_put(env, clobj);
+					clobj = NULL;
+				}
 
-			spin_lock(&cli->cl_lru_list_lock);
+				clobj = tmp;
+				io->ci_obj = clobj;
+				io->ci_ignore_layout = 1;
+				rc = cl_io_init(env, io, CIT_MISC, clobj);
 
-			if (rc != 0)
-				break;
+				spin_lock(&shard->cls_lock);
 
-			++maxscan;
-			continue;
-		}
+				if (rc != 0)
+					break;
 
-		if (cl_page_own_try(env, io, page) == 0) {
-			if (!lru_page_busy(cli, page)) {
-				/* remove it from lru list earlier to avoid
-				 * lock contention */
-				__osc_lru_del(cli, opg);
-				opg->ops_in_lru = 0; /* will be discarded */
-
-				cl_page_get(page);
-				will_free = true;
-			} else {
-				cl_page_disown(env, io, page);
+				++maxscan;
+				continue;
 			}
-		}
 
-		if (!will_free) {
-			list_move_tail(&opg->ops_lru, &cli->cl_lru_list);
-			continue;
-		}
+			if (cl_page_own_try(env, io, page) == 0) {
+				if (!lru_page_busy(cli, page)) {
+					/* remove it from lru list earlier to
+					 * avoid lock contention */
+					__osc_lru_del(cli, opg);
+					opg->ops_in_lru = 0; /* will be discarded */
+
+					cl_page_get(page);
+					will_free = true;
+				} else {
+					cl_page_disown(env, io, page);
+				}
+			}
+
+			if (!will_free) {
+				list_move_tail(&opg->ops_lru, &shard->cls_list);
+				continue;
+			}
 
-		/* Don't discard and free the page with cl_lru_list held */
-		pvec[index++] = page;
-		if (unlikely(index == OTI_PVEC_SIZE)) {
-			spin_unlock(&cli->cl_lru_list_lock);
-			discard_pagevec(env, io, pvec, index);
-			index = 0;
+			/* Don't discard and free the page with the LRU lock
+			 * held */
+			pvec[index++] = page;
+			if (unlikely(index == OTI_PVEC_SIZE)) {
+				spin_unlock(&shard->cls_lock);
+				discard_pagevec(env, io, pvec, index);
+				index = 0;
+
+				spin_lock(&shard->cls_lock);
+			}
 
-			spin_lock(&cli->cl_lru_list_lock);
+			if (++count >= target)
+				break;
 		}
+		spin_unlock(&shard->cls_lock);
 
-		if (++count >= target)
+		if (rc != 0 || maxscan < 0 || count >= target ||
+		    (!force && atomic_read(&cli->cl_lru_shrinkers) > 1))
 			break;
 	}
-	spin_unlock(&cli->cl_lru_list_lock);
 
 	if (clobj != NULL) {
 		discard_pagevec(env, io, pvec, index);
@@ -701,7 +765,7 @@ long osc_lru_shrink(const struct lu_env *env, struct client_obd *cli,
 	atomic_dec(&cli->cl_lru_shrinkers);
 	if (count > 0) {
 		atomic_long_add(count, cli->cl_lru_left);
-		wake_up_all(&osc_lru_waitq);
+		osc_lru_wakeup(true);
 	}
 	RETURN(count > 0 ? count : rc);
 }
@@ -887,7 +951,7 @@ unsigned long osc_lru_reserve(struct client_obd *cli, unsigned long npages)
 void osc_lru_unreserve(struct client_obd *cli, unsigned long npages)
 {
 	atomic_long_add(npages, cli->cl_lru_left);
-	wake_up_all(&osc_lru_waitq);
+	osc_lru_wakeup(true);
 }
 
 /**
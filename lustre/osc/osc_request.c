@@ -60,6 +60,12 @@ module_param(osc_reqpool_mem_max, uint, 0444);
 static int osc_idle_timeout = 20;
 module_param(osc_idle_timeout, uint, 0644);
 
+/* minimum RPC size in pages to generate T10-PI guards in parallel, 0 = off */
+static unsigned int osc_cksum_ptask_pages = 256;
+module_param(osc_cksum_ptask_pages, uint, 0644);
+
+static struct cfs_ptask_engine *osc_cksum_engine;
+
 #define osc_grant_args osc_brw_async_args
 
 struct osc_setattr_args {
@@ -1100,6 +1106,168 @@ static inline int can_merge_pages(struct brw_page *p1, struct brw_page *p2)
         return (p1->off + p1->count == p2->off);
 }
 
+/* number of pages handled by a single guard generation task */
+#define OSC_CKSUM_PTASK_CHUNK	64
+
+struct osc_cksum_ptask {
+	struct cfs_ptask	  ocp_task;
+	const char		 *ocp_obd_name;
+	struct brw_page		**ocp_pga;
+	obd_dif_csum_fn		 *ocp_fn;
+	__u16			 *ocp_guards;
+	int			  ocp_guard_number;
+	int			  ocp_used;
+	int			  ocp_nob;
+	int			  ocp_pg_count;
+	int			  ocp_sector_size;
+	bool			  ocp_submitted;
+};
+
+static int osc_cksum_guards(struct osc_cksum_ptask *ocp)
+{
+	int nob = ocp->ocp_nob;
+	int used;
+	int rc = 0;
+	int i;
+
+	for (i = 0; i < ocp->ocp_pg_count && nob > 0; i++) {
+		struct brw_page *pg = ocp->ocp_pga[i];
+		unsigned int count = pg->count > nob ? nob : pg->count;
+
+		rc = obd_page_dif_generate_buffer(ocp->ocp_obd_name, pg->pg,
+						  pg->off & ~PAGE_MASK, count,
+						  ocp->ocp_guards + ocp->ocp_used,
+						  ocp->ocp_guard_number -
+						  ocp->ocp_used,
+						  &used, ocp->ocp_sector_size,
+						  ocp->ocp_fn);
+		if (rc)
+			break;
+
+		ocp->ocp_used += used;
+		nob -= pg->count;
+	}
+
+	return rc;
+}
+
+static int osc_cksum_guards_ptask(struct cfs_ptask *ptask)
+{
+	return osc_cksum_guards(ptask->pt_cbdata);
+}
+
+static bool osc_cksum_ptask_enabled(size_t pg_count)
+{
+	return osc_cksum_ptask_pages != 0 &&
+	       pg_count >= osc_cksum_ptask_pages &&
+	       pg_count > OSC_CKSUM_PTASK_CHUNK &&
+	       cfs_ptengine_weight(osc_cksum_engine) > 1;
+}
+
+/**
+ * Generate the T10-PI guard tags of a large bulk on several CPUs.
+ *
+ * The pages are split into chunks of OSC_CKSUM_PTASK_CHUNK pages, and the
+ * guards of each chunk are computed by a separate task into its own buffer,
+ * the last chunk being done by the calling thread. The guard buffers are then
+ * fed to the top-level hash in page order, so the resulting checksum is the
+ * same as the one computed serially by osc_checksum_bulk_t10pi().
+ */
+static int osc_checksum_t10pi_ptask(const char *obd_name, int nob,
+				    size_t pg_count, struct brw_page **pga,
+				    obd_dif_csum_fn *fn, int sector_size,
+				    struct ahash_request *req)
+{
+	struct osc_cksum_ptask *tasks;
+	int guards_per_page = DIV_ROUND_UP(PAGE_SIZE, sector_size);
+	int ntasks = DIV_ROUND_UP(pg_count, OSC_CKSUM_PTASK_CHUNK);
+	int submitted = 0;
+	int rc = 0;
+	int rc2;
+	int i;
+	int j;
+
+	OBD_ALLOC(tasks, ntasks * sizeof(*tasks));
+	if (tasks == NULL)
+		return -ENOMEM;
+
+	for (i = 0; i < ntasks; i++) {
+		struct osc_cksum_ptask *ocp = &tasks[i];
+		int first = i * OSC_CKSUM_PTASK_CHUNK;
+
+		ocp->ocp_obd_name = obd_name;
+		ocp->ocp_pga = pga + first;
+		ocp->ocp_fn = fn;
+		ocp->ocp_nob = nob;
+		ocp->ocp_pg_count = min_t(int, pg_count - first,
+					  OSC_CKSUM_PTASK_CHUNK);
+		ocp->ocp_sector_size = sector_size;
+		ocp->ocp_guard_number = ocp->ocp_pg_count * guards_per_page;
+		OBD_ALLOC(ocp->ocp_guards,
+			  ocp->ocp_guard_number * sizeof(*ocp->ocp_guards));
+		if (ocp->ocp_guards == NULL)
+			GOTO(out_wait, rc = -ENOMEM);
+
+		for (j = 0; j < ocp->ocp_pg_count; j++)
+			nob -= pga[first + j]->count;
+
+		if (i == ntasks - 1)
+			break;
+
+		rc = cfs_ptask_init(&ocp->ocp_task, osc_cksum_guards_ptask, ocp,
+				    PTF_ORDERED | PTF_COMPLETE,
+				    smp_processor_id());
+		if (rc)
+			GOTO(out_wait, rc);
+
+		if (cfs_ptask_submit(&ocp->ocp_task, osc_cksum_engine) == 0) {
+			ocp->ocp_submitted = true;
+			continue;
+		}
+
+		/* the engine is busy, do this chunk ourselves */
+		rc = osc_cksum_guards(ocp);
+		if (rc)
+			GOTO(out_wait, rc);
+	}
+
+	rc = osc_cksum_guards(&tasks[ntasks - 1]);
+
+out_wait:
+	for (i = 0; i < ntasks; i++) {
+		if (!tasks[i].ocp_submitted)
+			continue;
+
+		submitted++;
+		rc2 = cfs_ptask_wait_for(&tasks[i].ocp_task);
+		LASSERTF(!rc2, "wait for task error: %d\n", rc2);
+
+		rc2 = cfs_ptask_result(&tasks[i].ocp_task);
+		if (rc2 && !rc)
+			rc = rc2;
+	}
+
+	for (i = 0; i < ntasks; i++) {
+		struct osc_cksum_ptask *ocp = &tasks[i];
+
+		if (ocp->ocp_guards == NULL)
+			continue;
+
+		if (rc == 0 && ocp->ocp_used != 0)
+			cfs_crypto_hash_update(req, ocp->ocp_guards,
+					       ocp->ocp_used *
+					       sizeof(*ocp->ocp_guards));
+		OBD_FREE(ocp->ocp_guards,
+			 ocp->ocp_guard_number * sizeof(*ocp->ocp_guards));
+	}
+	OBD_FREE(tasks, ntasks * sizeof(*tasks));
+
+	CDEBUG(D_INFO, "%s: T10-PI guards of %zu pages in %d chunks, %d in "
+	       "parallel: rc = %d\n", obd_name, pg_count, ntasks, submitted, rc);
+
+	return rc;
+}
+
 static int osc_checksum_bulk_t10pi(const char *obd_name, int nob,
 				   size_t pg_count, struct brw_page **pga,
 				   int opc, obd_dif_csum_fn *fn,
@@ -1134,23 +1302,31 @@ static int osc_checksum_bulk_t10pi(const char *obd_name, int nob,
 		GOTO(out, rc);
 	}
 
+	/* corrupt the data before we compute the checksum, to
+	 * simulate an OST->client data error */
+	if (unlikely(nob > 0 && opc == OST_READ &&
+		     OBD_FAIL_CHECK(OBD_FAIL_OSC_CHECKSUM_RECEIVE))) {
+		unsigned char *ptr = kmap(pga[0]->pg);
+		int off = pga[0]->off & ~PAGE_MASK;
+
+		memcpy(ptr + off, "bad1", min_t(typeof(nob), 4, nob));
+		kunmap(pga[0]->pg);
+	}
+
+	if (osc_cksum_ptask_enabled(pg_count)) {
+		rc = osc_checksum_t10pi_ptask(obd_name, nob, pg_count, pga, fn,
+					      sector_size, req);
+		if (rc)
+			GOTO(out, rc);
+		GOTO(out_final, rc);
+	}
+
 	buffer = kmap(__page);
 	guard_start = (__u16 *)buffer;
 	guard_number = PAGE_SIZE / sizeof(*guard_start);
 	while (nob > 0 && pg_count > 0) {
 		unsigned int count = pga[i]->count > nob ? nob : pga[i]->count;
 
-		/* corrupt the data before we compute the checksum, to
-		 * simulate an OST->client data error */
-		if (unlikely(i == 0 && opc == OST_READ &&
-			     OBD_FAIL_CHECK(OBD_FAIL_OSC_CHECKSUM_RECEIVE))) {
-			unsigned char *ptr = kmap(pga[i]->pg);
-			int off = pga[i]->off & ~PAGE_MASK;
-
-			memcpy(ptr + off, "bad1", min_t(typeof(nob), 4, nob));
-			kunmap(pga[i]->pg);
-		}
-
 		/*
 		 * The left guard number should be able to hold checksums of a
 		 * whole page
@@ -1184,6 +1360,7 @@ static int osc_checksum_bulk_t10pi(const char *obd_name, int nob,
 		cfs_crypto_hash_update_page(req, __page, 0,
 			used_number * sizeof(*guard_start));
 
+out_final:
 	bufsize = sizeof(cksum);
 	cfs_crypto_hash_final(req, (unsigned char *)&cksum, &bufsize);
 
@@ -2018,6 +2195,59 @@ static void osc_release_ppga(struct brw_page **ppga, size_t count)
         OBD_FREE(ppga, sizeof(*ppga) * count);
 }
 
+/*
+ * Adaptive RPC concurrency, in the spirit of TCP Vegas: the round trip time of
+ * completed BRW RPCs is compared with the lowest one seen. While the average
+ * stays close to the minimum the OST is not queueing our RPCs and the window
+ * grows by one per round (a window's worth of completed RPCs); once the
+ * average grows well above the minimum the RPCs are waiting in the OST queue
+ * and the window shrinks multiplicatively. The window never exceeds
+ * cl_max_rpcs_in_flight. The minimum is slowly pulled towards the average so
+ * that it follows a permanent change of the network or storage latency.
+ *
+ * Called with cl_loi_list_lock held.
+ */
+#define OSC_RPC_WINDOW_GROW_PCT		125
+#define OSC_RPC_WINDOW_SHRINK_PCT	200
+#define OSC_RPC_WINDOW_MIN_AGE		32
+
+static void osc_rpc_window_update(struct client_obd *cli,
+				  struct ptlrpc_request *req)
+{
+	u64 rtt;
+
+	if (cli->cl_rpc_window == 0)
+		return;
+
+	rtt = max_t(s64, ktime_us_delta(ktime_get_real(), req->rq_sent_ns), 1);
+	if (cli->cl_rpc_rtt_min_us == 0 || rtt < cli->cl_rpc_rtt_min_us)
+		cli->cl_rpc_rtt_min_us = rtt;
+	if (cli->cl_rpc_rtt_avg_us == 0)
+		cli->cl_rpc_rtt_avg_us = rtt;
+	else
+		cli->cl_rpc_rtt_avg_us = (cli->cl_rpc_rtt_avg_us * 7 + rtt) / 8;
+
+	if (++cli->cl_rpc_window_acks < cli->cl_rpc_window)
+		return;
+
+	/* one round of RPCs is done, adjust the window */
+	cli->cl_rpc_window_acks = 0;
+	if (cli->cl_rpc_rtt_avg_us * 100 <=
+	    cli->cl_rpc_rtt_min_us * OSC_RPC_WINDOW_GROW_PCT)
+		cli->cl_rpc_window++;
+	else if (cli->cl_rpc_rtt_avg_us * 100 >=
+		 cli->cl_rpc_rtt_min_us * OSC_RPC_WINDOW_SHRINK_PCT)
+		cli->cl_rpc_window = cli->cl_rpc_window * 3 / 4;
+	cli->cl_rpc_window = clamp_t(u32, cli->cl_rpc_window, 1,
+				     cli->cl_max_rpcs_in_flight);
+
+	if (++cli->cl_rpc_window_rounds >= OSC_RPC_WINDOW_MIN_AGE) {
+		cli->cl_rpc_window_rounds = 0;
+		cli->cl_rpc_rtt_min_us = (cli->cl_rpc_rtt_min_us * 3 +
+					  cli->cl_rpc_rtt_avg_us) / 4;
+	}
+}
+
 static int brw_interpret(const struct lu_env *env,
                          struct ptlrpc_request *req, void *data, int rc)
 {
@@ -2134,6 +2364,10 @@ static int brw_interpret(const struct lu_env *env,
 		cli->cl_w_in_flight--;
 	else
 		cli->cl_r_in_flight--;
+	if (rc == 0)
+		osc_rpc_window_update(cli, req);
+	if (rc == 0 && lustre_msg_get_opc(req->rq_reqmsg) == OST_WRITE)
+		osc_write_bw_update(cli, transferred);
 	osc_wake_cache_waiters(cli);
 	spin_unlock(&cli->cl_loi_list_lock);
 
@@ -3315,6 +3549,8 @@ int osc_cleanup_common(struct obd_device *obd)
 	list_del(&cli->cl_shrink_list);
 	spin_unlock(&osc_shrink_lock);
 
+	osc_write_bw_fini(cli);
+
 	/* lru cleanup */
 	if (cli->cl_cache != NULL) {
 		LASSERT(atomic_read(&cli->cl_cache->ccc_users) > 0);
@@ -3452,8 +3688,17 @@ static int __init osc_init(void)
 	if (rc != 0)
 		GOTO(out_req_pool, rc);
 
+	osc_cksum_engine = cfs_ptengine_init("osc_cksum", cpu_online_mask);
+	if (IS_ERR(osc_cksum_engine)) {
+		rc = PTR_ERR(osc_cksum_engine);
+		osc_cksum_engine = NULL;
+		GOTO(out_grant_work, rc);
+	}
+
 	RETURN(rc);
 
+out_grant_work:
+	osc_stop_grant_work();
 out_req_pool:
 	ptlrpc_free_rq_pool(osc_rq_pool);
 out_type:
@@ -3466,6 +3711,8 @@ out_kmem:
 
 static void __exit osc_exit(void)
 {
+	cfs_ptengine_fini(osc_cksum_engine);
+	osc_cksum_engine = NULL;
 	osc_stop_grant_work();
 	remove_shrinker(osc_cache_shrinker);
 	class_unregister_type(LUSTRE_OSC_NAME);
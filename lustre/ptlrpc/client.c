@@ -1096,6 +1096,7 @@ void ptlrpc_set_add_req(struct ptlrpc_request_set *set,
 	req->rq_set = set;
 	atomic_inc(&set->set_remaining);
 	req->rq_queued_time = ktime_get_seconds();
+	req->rq_cli.cr_queued_ns = ktime_get_real();
 
 	if (req->rq_reqmsg != NULL)
 		lustre_msg_set_jobid(req->rq_reqmsg, NULL);
@@ -1127,6 +1128,7 @@ void ptlrpc_set_add_new_req(struct ptlrpcd_ctl *pc,
 	 */
 	req->rq_set = set;
 	req->rq_queued_time = ktime_get_seconds();
+	req->rq_cli.cr_queued_ns = ktime_get_real();
 	list_add_tail(&req->rq_set_chain, &set->set_new_requests);
 	count = atomic_inc_return(&set->set_new_count);
 	spin_unlock(&set->set_new_req_lock);
@@ -1375,6 +1377,7 @@ static int after_reply(struct ptlrpc_request *req)
 
 	work_start = ktime_get_real();
 	timediff = ktime_us_delta(work_start, req->rq_sent_ns);
+	req->rq_cli.cr_replied_ns = work_start;
 
         /*
          * NB Until this point, the whole of the incoming message,
@@ -2047,6 +2050,7 @@ int ptlrpc_check_set(const struct lu_env *env, struct ptlrpc_request_set *set)
 			continue;
 		}
 		ptlrpc_rqphase_move(req, RQ_PHASE_COMPLETE);
+		ptlrpc_lprocfs_rpc_done(req);
 
 		if (req->rq_reqmsg != NULL)
 			CDEBUG(D_RPCTRACE,
@@ -39,6 +39,10 @@
 #include <obd_class.h>
 #include "ptlrpc_internal.h"
 
+struct ptlrpc_lat_stats;
+static void ptlrpc_lprocfs_rpc_latency_init(struct dentry *entry,
+					    struct ptlrpc_lat_stats **plsp,
+					    bool server);
 
 static struct ll_rpc_opcode {
      __u32       opcode;
@@ -476,6 +480,76 @@ static ssize_t threads_max_store(struct kobject *kobj, struct attribute *attr,
 }
 LUSTRE_RW_ATTR(threads_max);
 
+static ssize_t threads_idle_timeout_show(struct kobject *kobj,
+					 struct attribute *attr, char *buf)
+{
+	struct ptlrpc_service *svc = container_of(kobj, struct ptlrpc_service,
+						  srv_kobj);
+
+	return sprintf(buf, "%d\n", svc->srv_nthrs_idle_timeout);
+}
+
+static ssize_t threads_idle_timeout_store(struct kobject *kobj,
+					  struct attribute *attr,
+					  const char *buffer, size_t count)
+{
+	struct ptlrpc_service *svc = container_of(kobj, struct ptlrpc_service,
+						  srv_kobj);
+	struct ptlrpc_service_part *svcpt;
+	unsigned int val;
+	int rc;
+	int i;
+
+	rc = kstrtouint(buffer, 10, &val);
+	if (rc < 0)
+		return rc;
+
+	if (val > INT_MAX / MSEC_PER_SEC)
+		return -ERANGE;
+
+	spin_lock(&svc->srv_lock);
+	WRITE_ONCE(svc->srv_nthrs_idle_timeout, val);
+	spin_unlock(&svc->srv_lock);
+
+	/* threads sleeping on the old timeout wait again with the new one,
+	 * the idle ones at the tail of the exclusive waitqueue included */
+	ptlrpc_service_for_each_part(svcpt, i, svc)
+		wake_up_all(&svcpt->scp_waitq);
+
+	return count;
+}
+LUSTRE_RW_ATTR(threads_idle_timeout);
+
+static ssize_t threads_rebalance_show(struct kobject *kobj,
+				      struct attribute *attr, char *buf)
+{
+	struct ptlrpc_service *svc = container_of(kobj, struct ptlrpc_service,
+						  srv_kobj);
+
+	return sprintf(buf, "%u\n", svc->srv_nthrs_rebalance);
+}
+
+static ssize_t threads_rebalance_store(struct kobject *kobj,
+				       struct attribute *attr,
+				       const char *buffer, size_t count)
+{
+	struct ptlrpc_service *svc = container_of(kobj, struct ptlrpc_service,
+						  srv_kobj);
+	bool val;
+	int rc;
+
+	rc = kstrtobool(buffer, &val);
+	if (rc < 0)
+		return rc;
+
+	spin_lock(&svc->srv_lock);
+	svc->srv_nthrs_rebalance = val;
+	spin_unlock(&svc->srv_lock);
+
+	return count;
+}
+LUSTRE_RW_ATTR(threads_rebalance);
+
 /**
  * Translates \e ptlrpc_nrs_pol_state values to human-readable strings.
  *
@@ -1155,6 +1229,8 @@ static struct attribute *ptlrpc_svc_attrs[] = {
 	&lustre_attr_threads_min.attr,
 	&lustre_attr_threads_started.attr,
 	&lustre_attr_threads_max.attr,
+	&lustre_attr_threads_idle_timeout.attr,
+	&lustre_attr_threads_rebalance.attr,
 	&lustre_attr_high_priority_ratio.attr,
 	NULL,
 };
@@ -1233,6 +1309,9 @@ void ptlrpc_ldebugfs_register_service(struct dentry *entry,
 				 0400, &req_history_fops, svc);
 	if (rc)
 		CWARN("Error adding the req_history file\n");
+
+	ptlrpc_lprocfs_rpc_latency_init(svc->srv_debugfs_entry,
+					&svc->srv_lat_stats, true);
 }
 
 void ptlrpc_lprocfs_register_obd(struct obd_device *obddev)
@@ -1240,6 +1319,10 @@ void ptlrpc_lprocfs_register_obd(struct obd_device *obddev)
 	ptlrpc_ldebugfs_register(obddev->obd_debugfs_entry, NULL, "stats",
 				 &obddev->obd_svc_debugfs_entry,
 				 &obddev->obd_svc_stats);
+	if (obddev->obd_svc_stats != NULL)
+		ptlrpc_lprocfs_rpc_latency_init(obddev->obd_debugfs_entry,
+						&obddev->obd_svc_lat_stats,
+						false);
 }
 EXPORT_SYMBOL(ptlrpc_lprocfs_register_obd);
 
@@ -1285,6 +1368,517 @@ void ptlrpc_lprocfs_brw(struct ptlrpc_request *req, int bytes)
 
 EXPORT_SYMBOL(ptlrpc_lprocfs_brw);
 
+/*
+ * Per-stage RPC latency histograms.
+ *
+ * Each completed RPC is accounted once per stage in log2 microsecond
+ * buckets, both under its opcode and under its jobid. The opcode and jobid
+ * dimensions are kept apart rather than crossed, which would multiply the
+ * memory needed.
+ *
+ * Collection is off by default. Writing to the rpc_latency file enables it,
+ * writing "0" or "disable" disables it, and any write clears the histograms.
+ * The histograms are kept per CPT and only folded together when the file is
+ * read, so that accounting an RPC only takes the lock of the local CPT. Each
+ * CPT tracks the first PTLRPC_LAT_OPCS opcodes it sees, later ones are
+ * accounted as "other", and the PTLRPC_LAT_JOBS most recently active jobs,
+ * the least recently used job being recycled for a new one.
+ */
+#define PTLRPC_LAT_STAGES	4
+#define PTLRPC_LAT_JOBS		16
+#define PTLRPC_LAT_OPCS		32
+
+struct ptlrpc_lat_hist {
+	unsigned long		 plh_buckets[PTLRPC_LAT_STAGES][OBD_HIST_MAX];
+	char			 plh_jobid[LUSTRE_JOBID_SIZE];
+	time64_t		 plh_used;
+	bool			 plh_active;
+};
+
+/* histograms of one CPT, protected by plc_lock */
+struct ptlrpc_lat_cpt {
+	spinlock_t		 plc_lock;
+	/* slot of each opcode in plc_opcs plus one, 0 if not tracked yet */
+	u8			 plc_opc[LUSTRE_MAX_OPCODES];
+	int			 plc_nopcs;
+	/* the last slot accounts the opcodes which did not get one */
+	struct ptlrpc_lat_hist	 plc_opcs[PTLRPC_LAT_OPCS + 1];
+	struct ptlrpc_lat_hist	 plc_jobs[PTLRPC_LAT_JOBS];
+};
+
+struct ptlrpc_lat_stats {
+	/* serializes enabling, disabling and reading */
+	struct mutex		 pls_mutex;
+	int			 pls_nstages;
+	const char * const	*pls_stages;
+	ktime_t			 pls_start;
+	/* per-CPT histograms, NULL if collection is disabled */
+	struct ptlrpc_lat_cpt	* __rcu *pls_cpts;
+};
+
+static const char * const ptlrpc_lat_srv_stages[] = {
+	"wait",		/* arrival until a service thread takes it */
+	"handle",	/* request handler, including the reply send */
+	"total",
+};
+
+static const char * const ptlrpc_lat_cli_stages[] = {
+	"queue",	/* queued on a request set until sent */
+	"rpc",		/* sent until the reply arrives: network and server */
+	"reply",	/* reply processing and completion callback */
+	"total",
+};
+
+static struct ptlrpc_lat_stats *ptlrpc_lat_stats_alloc(bool server)
+{
+	struct ptlrpc_lat_stats *pls;
+
+	OBD_ALLOC_PTR(pls);
+	if (pls == NULL)
+		return NULL;
+
+	mutex_init(&pls->pls_mutex);
+	if (server) {
+		pls->pls_stages = ptlrpc_lat_srv_stages;
+		pls->pls_nstages = ARRAY_SIZE(ptlrpc_lat_srv_stages);
+	} else {
+		pls->pls_stages = ptlrpc_lat_cli_stages;
+		pls->pls_nstages = ARRAY_SIZE(ptlrpc_lat_cli_stages);
+	}
+
+	return pls;
+}
+
+/* Replace the per-CPT histograms with new empty ones, or none if !enable. */
+static int ptlrpc_lat_stats_reset(struct ptlrpc_lat_stats *pls, bool enable)
+{
+	struct ptlrpc_lat_cpt **cpts = NULL;
+	struct ptlrpc_lat_cpt **old;
+	struct ptlrpc_lat_cpt *plc;
+	int i;
+
+	if (enable) {
+		cpts = cfs_percpt_alloc(cfs_cpt_table, sizeof(*plc));
+		if (cpts == NULL)
+			return -ENOMEM;
+		cfs_percpt_for_each(plc, i, cpts)
+			spin_lock_init(&plc->plc_lock);
+	}
+
+	mutex_lock(&pls->pls_mutex);
+	old = rcu_dereference_protected(pls->pls_cpts,
+					lockdep_is_held(&pls->pls_mutex));
+	rcu_assign_pointer(pls->pls_cpts, cpts);
+	pls->pls_start = ktime_get_real();
+	mutex_unlock(&pls->pls_mutex);
+
+	if (old != NULL) {
+		synchronize_rcu();
+		cfs_percpt_free(old);
+	}
+
+	return 0;
+}
+
+static void ptlrpc_lat_stats_free(struct ptlrpc_lat_stats **plsp)
+{
+	struct ptlrpc_lat_stats *pls = *plsp;
+
+	if (pls == NULL)
+		return;
+
+	ptlrpc_lat_stats_reset(pls, false);
+	OBD_FREE_PTR(pls);
+	*plsp = NULL;
+}
+
+/* Find the opcode histogram, called with plc_lock held. */
+static struct ptlrpc_lat_hist *
+ptlrpc_lat_hist_opc(struct ptlrpc_lat_cpt *plc, int opc)
+{
+	int slot = plc->plc_opc[opc];
+
+	if (likely(slot != 0))
+		return &plc->plc_opcs[slot - 1];
+
+	if (plc->plc_nopcs == PTLRPC_LAT_OPCS)
+		return &plc->plc_opcs[PTLRPC_LAT_OPCS];
+
+	slot = plc->plc_nopcs++;
+	plc->plc_opc[opc] = slot + 1;
+
+	return &plc->plc_opcs[slot];
+}
+
+/* Find or recycle the job histogram, called with plc_lock held. */
+static struct ptlrpc_lat_hist *
+ptlrpc_lat_hist_job(struct ptlrpc_lat_cpt *plc, const char *jobid)
+{
+	struct ptlrpc_lat_hist *plh;
+	struct ptlrpc_lat_hist *victim = &plc->plc_jobs[0];
+	int i;
+
+	for (i = 0; i < PTLRPC_LAT_JOBS; i++) {
+		plh = &plc->plc_jobs[i];
+		if (!plh->plh_active) {
+			victim = plh;
+			break;
+		}
+		if (strncmp(plh->plh_jobid, jobid, LUSTRE_JOBID_SIZE) == 0)
+			return plh;
+		if (plh->plh_used < victim->plh_used)
+			victim = plh;
+	}
+
+	memset(victim->plh_buckets, 0, sizeof(victim->plh_buckets));
+	strlcpy(victim->plh_jobid, jobid, sizeof(victim->plh_jobid));
+	victim->plh_active = true;
+
+	return victim;
+}
+
+static void ptlrpc_lat_hist_tally(struct ptlrpc_lat_stats *pls,
+				  struct ptlrpc_lat_hist *plh, const s64 *usecs)
+{
+	unsigned int val;
+	int i;
+
+	for (i = 0; i < pls->pls_nstages; i++) {
+		val = clamp_t(s64, usecs[i], 0, UINT_MAX);
+		plh->plh_buckets[i][val == 0 ? 0 :
+				    min(fls(val - 1), OBD_HIST_MAX - 1)]++;
+	}
+}
+
+/**
+ * Account the per-stage latencies \a usecs of \a req, one value for each
+ * stage of \a pls, the last one being the total.
+ */
+static void ptlrpc_lat_stats_tally(struct ptlrpc_lat_stats *pls,
+				   struct ptlrpc_request *req,
+				   const s64 *usecs)
+{
+	struct ptlrpc_lat_cpt **cpts;
+	struct ptlrpc_lat_cpt *plc;
+	struct ptlrpc_lat_hist *plh;
+	char *jobid;
+	int opc;
+
+	if (pls == NULL || req->rq_reqmsg == NULL ||
+	    rcu_access_pointer(pls->pls_cpts) == NULL)
+		return;
+
+	opc = opcode_offset(lustre_msg_get_opc(req->rq_reqmsg));
+	if (opc < 0)
+		return;
+	LASSERT(opc < LUSTRE_MAX_OPCODES);
+	jobid = lustre_msg_get_jobid(req->rq_reqmsg);
+
+	rcu_read_lock();
+	cpts = rcu_dereference(pls->pls_cpts);
+	if (cpts == NULL)
+		goto out;
+
+	plc = cpts[cfs_cpt_current(cfs_cpt_table, 1)];
+	spin_lock(&plc->plc_lock);
+	plh = ptlrpc_lat_hist_opc(plc, opc);
+	ptlrpc_lat_hist_tally(pls, plh, usecs);
+	if (jobid != NULL && jobid[0] != '\0') {
+		plh = ptlrpc_lat_hist_job(plc, jobid);
+		plh->plh_used = ktime_get_seconds();
+		ptlrpc_lat_hist_tally(pls, plh, usecs);
+	}
+	spin_unlock(&plc->plc_lock);
+out:
+	rcu_read_unlock();
+}
+
+void ptlrpc_lprocfs_srv_latency(struct ptlrpc_service *svc,
+				struct ptlrpc_request *req,
+				s64 wait_usecs, s64 handle_usecs)
+{
+	s64 usecs[] = { wait_usecs, handle_usecs, wait_usecs + handle_usecs };
+
+	ptlrpc_lat_stats_tally(svc->srv_lat_stats, req, usecs);
+}
+
+void ptlrpc_lprocfs_rpc_done(struct ptlrpc_request *req)
+{
+	struct ptlrpc_cli_req *cr = &req->rq_cli;
+	struct ptlrpc_lat_stats *pls;
+	ktime_t now;
+	s64 usecs[4];
+
+	if (req->rq_import == NULL)
+		return;
+
+	pls = req->rq_import->imp_obd->obd_svc_lat_stats;
+	if (pls == NULL || rcu_access_pointer(pls->pls_cpts) == NULL)
+		return;
+
+	/* only RPCs which got a reply have all the stages */
+	if (!ktime_to_ns(cr->cr_queued_ns) || !ktime_to_ns(cr->cr_sent_ns) ||
+	    ktime_before(cr->cr_replied_ns, cr->cr_sent_ns))
+		return;
+
+	now = ktime_get_real();
+	usecs[0] = ktime_us_delta(cr->cr_sent_ns, cr->cr_queued_ns);
+	usecs[1] = ktime_us_delta(cr->cr_replied_ns, cr->cr_sent_ns);
+	usecs[2] = ktime_us_delta(now, cr->cr_replied_ns);
+	usecs[3] = ktime_us_delta(now, cr->cr_queued_ns);
+
+	ptlrpc_lat_stats_tally(pls, req, usecs);
+}
+
+/* Add the buckets of \a src to \a dst, called with the plc_lock of \a src. */
+static void ptlrpc_lat_hist_fold(struct ptlrpc_lat_hist *dst,
+				 const struct ptlrpc_lat_hist *src)
+{
+	int i;
+	int j;
+
+	for (i = 0; i < PTLRPC_LAT_STAGES; i++)
+		for (j = 0; j < OBD_HIST_MAX; j++)
+			dst->plh_buckets[i][j] += src->plh_buckets[i][j];
+}
+
+static void ptlrpc_lat_hist_show(struct seq_file *m,
+				 struct ptlrpc_lat_stats *pls,
+				 struct ptlrpc_lat_hist *plh)
+{
+	int last = -1;
+	int i;
+	int j;
+
+	for (i = 0; i < OBD_HIST_MAX; i++)
+		for (j = 0; j < pls->pls_nstages; j++)
+			if (plh->plh_buckets[j][i] != 0)
+				last = i;
+
+	seq_printf(m, "  %10s:", "usec");
+	for (j = 0; j < pls->pls_nstages; j++)
+		seq_printf(m, " %10s", pls->pls_stages[j]);
+	seq_putc(m, '\n');
+
+	for (i = 0; i <= last; i++) {
+		seq_printf(m, "  %10lu:", 1UL << i);
+		for (j = 0; j < pls->pls_nstages; j++)
+			seq_printf(m, " %10lu", plh->plh_buckets[j][i]);
+		seq_putc(m, '\n');
+	}
+}
+
+/* Fold the histograms of opcode \a opc, or of the untracked opcodes if
+ * \a opc is negative, from all CPTs into \a sum. */
+static bool ptlrpc_lat_fold_opc(struct ptlrpc_lat_cpt **cpts, int opc,
+				struct ptlrpc_lat_hist *sum)
+{
+	struct ptlrpc_lat_cpt *plc;
+	bool found = false;
+	int slot;
+	int i;
+
+	memset(sum, 0, sizeof(*sum));
+	cfs_percpt_for_each(plc, i, cpts) {
+		spin_lock(&plc->plc_lock);
+		/* the "other" slot is only used once all the others are */
+		if (opc < 0)
+			slot = plc->plc_nopcs == PTLRPC_LAT_OPCS ?
+			       PTLRPC_LAT_OPCS + 1 : 0;
+		else
+			slot = plc->plc_opc[opc];
+		if (slot != 0) {
+			ptlrpc_lat_hist_fold(sum, &plc->plc_opcs[slot - 1]);
+			found = true;
+		}
+		spin_unlock(&plc->plc_lock);
+	}
+
+	return found;
+}
+
+/* Fold the histograms of job \a jobid from all CPTs into \a sum. */
+static void ptlrpc_lat_fold_job(struct ptlrpc_lat_cpt **cpts,
+				const char *jobid,
+				struct ptlrpc_lat_hist *sum)
+{
+	struct ptlrpc_lat_cpt *plc;
+	struct ptlrpc_lat_hist *plh;
+	int i;
+	int j;
+
+	memset(sum, 0, sizeof(*sum));
+	strlcpy(sum->plh_jobid, jobid, sizeof(sum->plh_jobid));
+	cfs_percpt_for_each(plc, i, cpts) {
+		spin_lock(&plc->plc_lock);
+		for (j = 0; j < PTLRPC_LAT_JOBS; j++) {
+			plh = &plc->plc_jobs[j];
+			if (plh->plh_active &&
+			    strncmp(plh->plh_jobid, jobid,
+				    LUSTRE_JOBID_SIZE) == 0) {
+				ptlrpc_lat_hist_fold(sum, plh);
+				break;
+			}
+		}
+		spin_unlock(&plc->plc_lock);
+	}
+}
+
+/* Whether job \a jobid of CPT \a cpt, slot \a slot was already shown. */
+static bool ptlrpc_lat_job_shown(struct ptlrpc_lat_cpt **cpts, int cpt,
+				 int slot, const char *jobid)
+{
+	struct ptlrpc_lat_cpt *plc;
+	bool shown = false;
+	int i;
+	int j;
+
+	for (i = 0; i <= cpt && !shown; i++) {
+		plc = cpts[i];
+		spin_lock(&plc->plc_lock);
+		for (j = 0; j < (i == cpt ? slot : PTLRPC_LAT_JOBS); j++) {
+			if (plc->plc_jobs[j].plh_active &&
+			    strncmp(plc->plc_jobs[j].plh_jobid, jobid,
+				    LUSTRE_JOBID_SIZE) == 0) {
+				shown = true;
+				break;
+			}
+		}
+		spin_unlock(&plc->plc_lock);
+	}
+
+	return shown;
+}
+
+static int ptlrpc_lprocfs_rpc_latency_seq_show(struct seq_file *m, void *v)
+{
+	struct ptlrpc_lat_stats *pls = m->private;
+	struct ptlrpc_lat_cpt **cpts;
+	struct ptlrpc_lat_cpt *plc;
+	struct ptlrpc_lat_hist *sum;
+	char jobid[LUSTRE_JOBID_SIZE];
+	struct timespec64 start;
+	struct timespec64 now;
+	int i;
+	int j;
+
+	mutex_lock(&pls->pls_mutex);
+	cpts = rcu_dereference_protected(pls->pls_cpts,
+					 lockdep_is_held(&pls->pls_mutex));
+	if (cpts == NULL) {
+		seq_puts(m, "disabled\n write anything to this file to activate, then '0' or 'disable' to deactivate\n");
+		goto out;
+	}
+
+	OBD_ALLOC_PTR(sum);
+	if (sum == NULL) {
+		mutex_unlock(&pls->pls_mutex);
+		return -ENOMEM;
+	}
+
+	ktime_get_real_ts64(&now);
+	start = ktime_to_timespec64(pls->pls_start);
+	seq_printf(m, "snapshot_time:         %lld.%09lu (secs.nsecs)\n",
+		   (s64)now.tv_sec, now.tv_nsec);
+	seq_printf(m, "start_time:            %lld.%09lu (secs.nsecs)\n",
+		   (s64)start.tv_sec, start.tv_nsec);
+
+	for (i = 0; i < LUSTRE_MAX_OPCODES; i++) {
+		if (!ptlrpc_lat_fold_opc(cpts, i, sum))
+			continue;
+
+		seq_printf(m, "opcode: %s\n",
+			   ll_opcode2str(ll_rpc_opcode_table[i].opcode));
+		ptlrpc_lat_hist_show(m, pls, sum);
+	}
+	if (ptlrpc_lat_fold_opc(cpts, -1, sum)) {
+		seq_puts(m, "opcode: other\n");
+		ptlrpc_lat_hist_show(m, pls, sum);
+	}
+
+	/* show each job once, summed over the CPTs which track it */
+	cfs_percpt_for_each(plc, i, cpts) {
+		for (j = 0; j < PTLRPC_LAT_JOBS; j++) {
+			spin_lock(&plc->plc_lock);
+			jobid[0] = '\0';
+			if (plc->plc_jobs[j].plh_active)
+				strlcpy(jobid, plc->plc_jobs[j].plh_jobid,
+					sizeof(jobid));
+			spin_unlock(&plc->plc_lock);
+
+			if (jobid[0] == '\0' ||
+			    ptlrpc_lat_job_shown(cpts, i, j, jobid))
+				continue;
+
+			ptlrpc_lat_fold_job(cpts, jobid, sum);
+			seq_printf(m, "job_id: %s\n", jobid);
+			ptlrpc_lat_hist_show(m, pls, sum);
+		}
+	}
+
+	OBD_FREE_PTR(sum);
+out:
+	mutex_unlock(&pls->pls_mutex);
+
+	return 0;
+}
+
+static ssize_t
+ptlrpc_lprocfs_rpc_latency_seq_write(struct file *file,
+				     const char __user *buffer,
+				     size_t count, loff_t *off)
+{
+	struct seq_file *m = file->private_data;
+	struct ptlrpc_lat_stats *pls = m->private;
+	char kernbuf[16] = "";
+	bool enable = true;
+	int rc;
+
+	if (count == 0)
+		return -EINVAL;
+
+	/* like the llite extents stats, "0" or "disable" stops collecting,
+	 * anything else starts it, and any write clears the histograms */
+	if (count < sizeof(kernbuf)) {
+		if (copy_from_user(kernbuf, buffer, count))
+			return -EFAULT;
+		kernbuf[count] = '\0';
+		if (strcmp(strim(kernbuf), "0") == 0 ||
+		    strncasecmp(kernbuf, "disable", 7) == 0)
+			enable = false;
+	}
+
+	rc = ptlrpc_lat_stats_reset(pls, enable);
+
+	return rc < 0 ? rc : count;
+}
+
+LDEBUGFS_SEQ_FOPS(ptlrpc_lprocfs_rpc_latency);
+
+static void ptlrpc_lprocfs_rpc_latency_init(struct dentry *entry,
+					    struct ptlrpc_lat_stats **plsp,
+					    bool server)
+{
+	struct ptlrpc_lat_stats *pls;
+	int rc;
+
+	if (IS_ERR_OR_NULL(entry))
+		return;
+
+	pls = ptlrpc_lat_stats_alloc(server);
+	if (pls == NULL)
+		return;
+
+	rc = ldebugfs_seq_create(entry, "rpc_latency", 0644,
+				 &ptlrpc_lprocfs_rpc_latency_fops, pls);
+	if (rc) {
+		CWARN("Error adding the rpc_latency file: rc = %d\n", rc);
+		ptlrpc_lat_stats_free(&pls);
+		return;
+	}
+	*plsp = pls;
+}
+
 void ptlrpc_lprocfs_unregister_service(struct ptlrpc_service *svc)
 {
 	if (!IS_ERR_OR_NULL(svc->srv_debugfs_entry))
@@ -1292,6 +1886,8 @@ void ptlrpc_lprocfs_unregister_service(struct ptlrpc_service *svc)
 
         if (svc->srv_stats)
                 lprocfs_free_stats(&svc->srv_stats);
+
+	ptlrpc_lat_stats_free(&svc->srv_lat_stats);
 }
 
 void ptlrpc_lprocfs_unregister_obd(struct obd_device *obd)
@@ -1306,6 +1902,8 @@ void ptlrpc_lprocfs_unregister_obd(struct obd_device *obd)
 
         if (obd->obd_svc_stats)
                 lprocfs_free_stats(&obd->obd_svc_stats);
+
+	ptlrpc_lat_stats_free(&obd->obd_svc_lat_stats);
 }
 EXPORT_SYMBOL(ptlrpc_lprocfs_unregister_obd);
 
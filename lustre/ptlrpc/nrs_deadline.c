@@ -0,0 +1,708 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; If not, see
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * GPL HEADER END
+ */
+/*
+ * lustre/ptlrpc/nrs_deadline.c
+ *
+ * Network Request Scheduler (NRS) Deadline policy
+ *
+ * This policy handles requests in order of their adaptive timeout deadline,
+ * i.e. earliest deadline first.
+ */
+/**
+ * \addtogoup nrs
+ * @{
+ */
+
+#define DEBUG_SUBSYSTEM S_RPC
+#include <obd_support.h>
+#include <obd_class.h>
+#include "ptlrpc_internal.h"
+
+#ifdef HAVE_SERVER_SUPPORT
+
+/**
+ * \name deadline
+ *
+ * The deadline policy schedules RPCs in order of ptlrpc_request::rq_deadline,
+ * the time by which the client expects a reply. Requests of jobs matching one
+ * of the configured JobID patterns belong to the interactive class, and their
+ * deadline is moved ahead by a configurable number of seconds so that they
+ * are handled ahead of the bulk requests queued at the same time. Requests
+ * with the same deadline are handled in FIFO order.
+ *
+ * The policy counts, for each class, the requests that started being handled
+ * after their deadline had already passed.
+ *
+ * @{
+ */
+
+#define NRS_POL_NAME_DEADLINE	"deadline"
+
+/* Default deadline boost of interactive requests, in seconds. */
+#define NRS_DL_BOOST_DEFAULT	30
+
+static const char *nrs_deadline_class_names[NRS_DL_CLASS_MAX] = {
+	[NRS_DL_CLASS_INTERACTIVE]	= "interactive",
+	[NRS_DL_CLASS_BULK]		= "bulk",
+};
+
+/**
+ * Binary heap predicate.
+ *
+ * Elements are sorted according to the deadline key assigned to the requests
+ * upon enqueue, and then by their enqueue sequence.
+ *
+ * \retval 0 e1 should be handled after e2
+ * \retval 1 e1 should be handled before e2
+ */
+static int deadline_req_compare(struct cfs_binheap_node *e1,
+				struct cfs_binheap_node *e2)
+{
+	struct ptlrpc_nrs_request *nrq1;
+	struct ptlrpc_nrs_request *nrq2;
+
+	nrq1 = container_of(e1, struct ptlrpc_nrs_request, nr_node);
+	nrq2 = container_of(e2, struct ptlrpc_nrs_request, nr_node);
+
+	if (nrq1->nr_u.deadline.dr_key != nrq2->nr_u.deadline.dr_key)
+		return nrq1->nr_u.deadline.dr_key <
+		       nrq2->nr_u.deadline.dr_key;
+
+	return nrq1->nr_u.deadline.dr_sequence <
+	       nrq2->nr_u.deadline.dr_sequence;
+}
+
+static struct cfs_binheap_ops nrs_deadline_heap_ops = {
+	.hop_enter	= NULL,
+	.hop_exit	= NULL,
+	.hop_compare	= deadline_req_compare,
+};
+
+/**
+ * Is called before the policy transitions into
+ * ptlrpc_nrs_pol_state::NRS_POL_STATE_STARTED; allocates and initializes
+ * the deadline-specific private data structure.
+ *
+ * \param[in] policy The policy to start
+ * \param[in] Generic char buffer; unused in this policy
+ *
+ * \retval -ENOMEM OOM error
+ * \retval  0	   success
+ *
+ * \see nrs_policy_register()
+ * \see nrs_policy_ctl()
+ */
+static int nrs_deadline_start(struct ptlrpc_nrs_policy *policy, char *arg)
+{
+	struct nrs_deadline_data *dl_data;
+
+	ENTRY;
+
+	OBD_CPT_ALLOC_PTR(dl_data, nrs_pol2cptab(policy),
+			  nrs_pol2cptid(policy));
+	if (dl_data == NULL)
+		RETURN(-ENOMEM);
+
+	dl_data->dl_binheap = cfs_binheap_create(&nrs_deadline_heap_ops,
+						 CBH_FLAG_ATOMIC_GROW,
+						 4096, NULL,
+						 nrs_pol2cptab(policy),
+						 nrs_pol2cptid(policy));
+	if (dl_data->dl_binheap == NULL) {
+		OBD_FREE_PTR(dl_data);
+		RETURN(-ENOMEM);
+	}
+
+	dl_data->dl_boost = NRS_DL_BOOST_DEFAULT;
+
+	policy->pol_private = dl_data;
+
+	RETURN(0);
+}
+
+/**
+ * Is called before the policy transitions into
+ * ptlrpc_nrs_pol_state::NRS_POL_STATE_STOPPED; deallocates the
+ * deadline-specific private data structure.
+ *
+ * \param[in] policy The policy to stop
+ *
+ * \see nrs_policy_stop0()
+ */
+static void nrs_deadline_stop(struct ptlrpc_nrs_policy *policy)
+{
+	struct nrs_deadline_data *dl_data = policy->pol_private;
+
+	LASSERT(dl_data != NULL);
+	LASSERT(dl_data->dl_binheap != NULL);
+	LASSERT(cfs_binheap_is_empty(dl_data->dl_binheap));
+
+	cfs_binheap_destroy(dl_data->dl_binheap);
+
+	OBD_FREE_PTR(dl_data);
+}
+
+/**
+ * Is called for obtaining a deadline policy resource.
+ *
+ * \param[in]  policy	  The policy on which the request is being asked for
+ * \param[in]  nrq	  The request for which resources are being taken
+ * \param[in]  parent	  Parent resource, unused in this policy
+ * \param[out] resp	  Resources references are placed in this array
+ * \param[in]  moving_req Signifies limited caller context; unused in this
+ *			  policy
+ *
+ * \retval 1 The deadline policy only has a one-level resource hierarchy
+ *
+ * \see nrs_resource_get_safe()
+ */
+static int nrs_deadline_res_get(struct ptlrpc_nrs_policy *policy,
+				struct ptlrpc_nrs_request *nrq,
+				const struct ptlrpc_nrs_resource *parent,
+				struct ptlrpc_nrs_resource **resp,
+				bool moving_req)
+{
+	*resp = &((struct nrs_deadline_data *)policy->pol_private)->dl_res;
+	return 1;
+}
+
+/**
+ * Called when getting a request from the deadline policy for handling, or
+ * just peeking; removes the request from the policy when it is to be handled,
+ * and accounts it in the statistics of its class.
+ *
+ * \param[in] policy The policy
+ * \param[in] peek   When set, signifies that we just want to examine the
+ *		     request, and not handle it, so the request is not removed
+ *		     from the policy.
+ * \param[in] force  Force the policy to return a request; unused in this
+ *		     policy
+ *
+ * \retval The request to be handled
+ * \retval NULL no request available
+ *
+ * \see ptlrpc_nrs_req_get_nolock()
+ * \see nrs_request_get()
+ */
+static
+struct ptlrpc_nrs_request *nrs_deadline_req_get(struct ptlrpc_nrs_policy *policy,
+						bool peek, bool force)
+{
+	struct nrs_deadline_data *dl_data = policy->pol_private;
+	struct cfs_binheap_node *node;
+	struct ptlrpc_nrs_request *nrq;
+	struct ptlrpc_request *req;
+	enum nrs_deadline_class class;
+
+	node = cfs_binheap_root(dl_data->dl_binheap);
+	nrq = unlikely(node == NULL) ? NULL :
+	      container_of(node, struct ptlrpc_nrs_request, nr_node);
+
+	if (nrq == NULL || peek)
+		return nrq;
+
+	cfs_binheap_remove(dl_data->dl_binheap, &nrq->nr_node);
+
+	class = nrq->nr_u.deadline.dr_class;
+	dl_data->dl_stats.ds_dispatched[class]++;
+	if (ktime_get_real_seconds() > nrq->nr_u.deadline.dr_deadline)
+		dl_data->dl_stats.ds_missed[class]++;
+
+	req = container_of(nrq, struct ptlrpc_request, rq_nrq);
+	CDEBUG(D_RPCTRACE, "NRS: starting to handle %s %s request from %s, "
+	       "deadline %lld\n", policy->pol_desc->pd_name,
+	       nrs_deadline_class_names[class], libcfs_id2str(req->rq_peer),
+	       (s64)nrq->nr_u.deadline.dr_deadline);
+
+	return nrq;
+}
+
+/**
+ * Returns the latency class of request \a req: interactive if its JobID
+ * matches one of the configured patterns, bulk otherwise.
+ */
+static enum nrs_deadline_class
+nrs_deadline_classify(struct nrs_deadline_data *dl_data,
+		      struct ptlrpc_request *req)
+{
+	struct nrs_deadline_jobids *jobids = &dl_data->dl_jobids;
+	char *jobid;
+	int i;
+
+	if (jobids->dj_count == 0)
+		return NRS_DL_CLASS_BULK;
+
+	jobid = lustre_msg_get_jobid(req->rq_reqmsg);
+	if (jobid == NULL || jobid[0] == '\0')
+		return NRS_DL_CLASS_BULK;
+
+	for (i = 0; i < jobids->dj_count; i++)
+		if (cfs_match_wildcard(jobids->dj_jobid[i], jobid))
+			return NRS_DL_CLASS_INTERACTIVE;
+
+	return NRS_DL_CLASS_BULK;
+}
+
+/**
+ * Adds request \a nrq to a deadline \a policy instance's set of queued
+ * requests.
+ *
+ * The deadline of the request is sampled at enqueue time, as it may be
+ * extended by early replies while the request is queued, and moved ahead by
+ * the boost for interactive requests.
+ *
+ * \param[in] policy The policy
+ * \param[in] nrq    The request to add
+ *
+ * \retval 0 request added
+ * \retval != 0 error
+ */
+static int nrs_deadline_req_add(struct ptlrpc_nrs_policy *policy,
+				struct ptlrpc_nrs_request *nrq)
+{
+	struct nrs_deadline_data *dl_data = policy->pol_private;
+	struct nrs_deadline_req *dr = &nrq->nr_u.deadline;
+	struct ptlrpc_request *req = container_of(nrq, struct ptlrpc_request,
+						  rq_nrq);
+
+	dr->dr_class = nrs_deadline_classify(dl_data, req);
+	dr->dr_deadline = req->rq_deadline;
+	dr->dr_key = req->rq_deadline;
+	if (dr->dr_class == NRS_DL_CLASS_INTERACTIVE)
+		dr->dr_key -= dl_data->dl_boost;
+	dr->dr_sequence = dl_data->dl_sequence++;
+
+	return cfs_binheap_insert(dl_data->dl_binheap, &nrq->nr_node);
+}
+
+/**
+ * Removes request \a nrq from \a policy's list of queued requests.
+ *
+ * \param[in] policy The policy
+ * \param[in] nrq    The request to remove
+ */
+static void nrs_deadline_req_del(struct ptlrpc_nrs_policy *policy,
+				 struct ptlrpc_nrs_request *nrq)
+{
+	struct nrs_deadline_data *dl_data = policy->pol_private;
+
+	cfs_binheap_remove(dl_data->dl_binheap, &nrq->nr_node);
+}
+
+/**
+ * Prints a debug statement right before the request \a nrq stops being
+ * handled.
+ *
+ * \param[in] policy The policy handling the request
+ * \param[in] nrq    The request being handled
+ *
+ * \see ptlrpc_server_finish_request()
+ * \see ptlrpc_nrs_req_stop_nolock()
+ */
+static void nrs_deadline_req_stop(struct ptlrpc_nrs_policy *policy,
+				  struct ptlrpc_nrs_request *nrq)
+{
+	struct ptlrpc_request *req = container_of(nrq, struct ptlrpc_request,
+						  rq_nrq);
+
+	DEBUG_REQ(D_RPCTRACE, req,
+		  "NRS: finished handling %s %s request from %s, deadline %lld",
+		  policy->pol_desc->pd_name,
+		  nrs_deadline_class_names[nrq->nr_u.deadline.dr_class],
+		  libcfs_id2str(req->rq_peer),
+		  (s64)nrq->nr_u.deadline.dr_deadline);
+}
+
+/**
+ * Performs ctl functions specific to deadline policy instances; similar to
+ * ioctl
+ *
+ * \param[in]     policy the policy instance
+ * \param[in]     opc    the opcode
+ * \param[in,out] arg    used for passing parameters and information
+ *
+ * \pre assert_spin_locked(&policy->pol_nrs->->nrs_lock)
+ * \post assert_spin_locked(&policy->pol_nrs->->nrs_lock)
+ *
+ * \retval 0   operation carried out successfully
+ * \retval -ve error
+ */
+static int nrs_deadline_ctl(struct ptlrpc_nrs_policy *policy,
+			    enum ptlrpc_nrs_ctl opc, void *arg)
+{
+	struct nrs_deadline_data *dl_data = policy->pol_private;
+
+	assert_spin_locked(&policy->pol_nrs->nrs_lock);
+
+	switch ((enum nrs_ctl_deadline)opc) {
+	default:
+		RETURN(-EINVAL);
+
+	case NRS_CTL_DEADLINE_RD_BOOST:
+		*(__u32 *)arg = dl_data->dl_boost;
+		break;
+
+	case NRS_CTL_DEADLINE_WR_BOOST:
+		dl_data->dl_boost = *(__u32 *)arg;
+		break;
+
+	case NRS_CTL_DEADLINE_RD_JOBIDS:
+		*(struct nrs_deadline_jobids *)arg = dl_data->dl_jobids;
+		break;
+
+	case NRS_CTL_DEADLINE_WR_JOBIDS:
+		dl_data->dl_jobids = *(struct nrs_deadline_jobids *)arg;
+		break;
+
+	/* statistics are summed up over all service partitions */
+	case NRS_CTL_DEADLINE_RD_STATS: {
+		struct nrs_deadline_stats *stats = arg;
+		int i;
+
+		for (i = 0; i < NRS_DL_CLASS_MAX; i++) {
+			stats->ds_dispatched[i] +=
+				dl_data->dl_stats.ds_dispatched[i];
+			stats->ds_missed[i] += dl_data->dl_stats.ds_missed[i];
+		}
+		break;
+	}
+	}
+	RETURN(0);
+}
+
+/**
+ * debugfs interface
+ */
+
+#define LPROCFS_NRS_DL_BOOST_MAX	65535
+
+/**
+ * Applies the control operation \a opc with argument \a arg to the deadline
+ * policy instances of both the regular and high-priority NRS heads of \a svc.
+ * -ENODEV from either head is ignored, as long as the policy is started on
+ * the other one.
+ */
+static int nrs_deadline_ctl_both(struct ptlrpc_service *svc,
+				 enum ptlrpc_nrs_ctl opc, void *arg)
+{
+	int rc;
+	int rc2;
+
+	rc = ptlrpc_nrs_policy_control(svc, PTLRPC_NRS_QUEUE_REG,
+				       NRS_POL_NAME_DEADLINE, opc, false, arg);
+	if (rc != 0 && rc != -ENODEV)
+		return rc;
+
+	if (!nrs_svc_has_hp(svc))
+		return rc;
+
+	rc2 = ptlrpc_nrs_policy_control(svc, PTLRPC_NRS_QUEUE_HP,
+					NRS_POL_NAME_DEADLINE, opc, false, arg);
+	if (rc2 != -ENODEV)
+		return rc2;
+
+	return rc;
+}
+
+/**
+ * Retrieves the deadline boost of interactive requests for deadline policy
+ * instances on both the regular and high-priority NRS head of a service, as
+ * long as a policy instance is not in the
+ * ptlrpc_nrs_pol_state::NRS_POL_STATE_STOPPED state;
+ */
+static int
+ptlrpc_lprocfs_nrs_deadline_boost_seq_show(struct seq_file *m, void *data)
+{
+	struct ptlrpc_service *svc = m->private;
+	__u32 boost;
+	int rc;
+
+	rc = ptlrpc_nrs_policy_control(svc, PTLRPC_NRS_QUEUE_REG,
+				       NRS_POL_NAME_DEADLINE,
+				       NRS_CTL_DEADLINE_RD_BOOST,
+				       true, &boost);
+	if (rc == 0)
+		seq_printf(m, "reg_boost:%u\n", boost);
+	else if (rc != -ENODEV)
+		return rc;
+
+	if (!nrs_svc_has_hp(svc))
+		return 0;
+
+	rc = ptlrpc_nrs_policy_control(svc, PTLRPC_NRS_QUEUE_HP,
+				       NRS_POL_NAME_DEADLINE,
+				       NRS_CTL_DEADLINE_RD_BOOST,
+				       true, &boost);
+	if (rc == 0)
+		seq_printf(m, "hp_boost:%u\n", boost);
+	else if (rc == -ENODEV)
+		rc = 0;
+
+	return rc;
+}
+
+/**
+ * Sets the number of seconds by which the deadline of interactive requests is
+ * moved ahead, on both the regular and high-priority NRS heads of a service.
+ *
+ * For example:
+ *
+ * lctl set_param ost.OSS.ost_io.nrs_deadline_boost=60
+ */
+static ssize_t
+ptlrpc_lprocfs_nrs_deadline_boost_seq_write(struct file *file,
+					    const char __user *buffer,
+					    size_t count, loff_t *off)
+{
+	struct seq_file *m = file->private_data;
+	struct ptlrpc_service *svc = m->private;
+	__u32 boost;
+	int rc;
+
+	rc = kstrtouint_from_user(buffer, count, 0, &boost);
+	if (rc)
+		return rc;
+
+	if (boost > LPROCFS_NRS_DL_BOOST_MAX)
+		return -ERANGE;
+
+	rc = nrs_deadline_ctl_both(svc, NRS_CTL_DEADLINE_WR_BOOST, &boost);
+
+	return rc ?: count;
+}
+LDEBUGFS_SEQ_FOPS(ptlrpc_lprocfs_nrs_deadline_boost);
+
+static void nrs_deadline_jobids_seq_print(struct seq_file *m,
+					  const char *prefix,
+					  struct nrs_deadline_jobids *jobids)
+{
+	int i;
+
+	seq_printf(m, "%sjobids:", prefix);
+	for (i = 0; i < jobids->dj_count; i++)
+		seq_printf(m, " %s", jobids->dj_jobid[i]);
+	seq_putc(m, '\n');
+}
+
+/**
+ * Retrieves the JobID patterns of the interactive class for deadline policy
+ * instances on both the regular and high-priority NRS head of a service.
+ */
+static int
+ptlrpc_lprocfs_nrs_deadline_jobids_seq_show(struct seq_file *m, void *data)
+{
+	struct ptlrpc_service *svc = m->private;
+	struct nrs_deadline_jobids *jobids;
+	int rc;
+
+	OBD_ALLOC_PTR(jobids);
+	if (jobids == NULL)
+		return -ENOMEM;
+
+	rc = ptlrpc_nrs_policy_control(svc, PTLRPC_NRS_QUEUE_REG,
+				       NRS_POL_NAME_DEADLINE,
+				       NRS_CTL_DEADLINE_RD_JOBIDS,
+				       true, jobids);
+	if (rc == 0)
+		nrs_deadline_jobids_seq_print(m, "reg_", jobids);
+	else if (rc != -ENODEV)
+		GOTO(out, rc);
+
+	if (!nrs_svc_has_hp(svc))
+		GOTO(out, rc = 0);
+
+	rc = ptlrpc_nrs_policy_control(svc, PTLRPC_NRS_QUEUE_HP,
+				       NRS_POL_NAME_DEADLINE,
+				       NRS_CTL_DEADLINE_RD_JOBIDS,
+				       true, jobids);
+	if (rc == 0)
+		nrs_deadline_jobids_seq_print(m, "hp_", jobids);
+	else if (rc == -ENODEV)
+		rc = 0;
+out:
+	OBD_FREE_PTR(jobids);
+
+	return rc;
+}
+
+/**
+ * Sets the JobID patterns of the interactive class, as a space separated list
+ * of at most NRS_DL_JOBID_MAX patterns, which may contain '*' wildcards. An
+ * empty list puts all requests into the bulk class.
+ *
+ * For example:
+ *
+ * lctl set_param ost.OSS.ost_io.nrs_deadline_jobids="vim.* ls.*"
+ *
+ * With jobid_var=procname_uid, "*.1000" selects all jobs of user 1000.
+ */
+static ssize_t
+ptlrpc_lprocfs_nrs_deadline_jobids_seq_write(struct file *file,
+					     const char __user *buffer,
+					     size_t count, loff_t *off)
+{
+	struct seq_file *m = file->private_data;
+	struct ptlrpc_service *svc = m->private;
+	struct nrs_deadline_jobids *jobids;
+	char *kernbuf;
+	char *pos;
+	char *tok;
+	int rc;
+
+	if (count > NRS_DL_JOBID_MAX * LUSTRE_JOBID_SIZE)
+		return -E2BIG;
+
+	OBD_ALLOC(kernbuf, count + 1);
+	if (kernbuf == NULL)
+		return -ENOMEM;
+
+	OBD_ALLOC_PTR(jobids);
+	if (jobids == NULL)
+		GOTO(out_kernbuf, rc = -ENOMEM);
+
+	if (copy_from_user(kernbuf, buffer, count))
+		GOTO(out, rc = -EFAULT);
+
+	pos = kernbuf;
+	while ((tok = strsep(&pos, " \t\n")) != NULL) {
+		if (*tok == '\0')
+			continue;
+
+		if (jobids->dj_count == NRS_DL_JOBID_MAX ||
+		    strlen(tok) >= LUSTRE_JOBID_SIZE)
+			GOTO(out, rc = -EINVAL);
+
+		strlcpy(jobids->dj_jobid[jobids->dj_count++], tok,
+			LUSTRE_JOBID_SIZE);
+	}
+
+	rc = nrs_deadline_ctl_both(svc, NRS_CTL_DEADLINE_WR_JOBIDS, jobids);
+out:
+	OBD_FREE_PTR(jobids);
+out_kernbuf:
+	OBD_FREE(kernbuf, count + 1);
+
+	return rc ?: count;
+}
+LDEBUGFS_SEQ_FOPS(ptlrpc_lprocfs_nrs_deadline_jobids);
+
+static void nrs_deadline_stats_seq_print(struct seq_file *m,
+					 const char *prefix,
+					 struct nrs_deadline_stats *stats)
+{
+	int i;
+
+	for (i = 0; i < NRS_DL_CLASS_MAX; i++)
+		seq_printf(m, "%s%s: { dispatched: %llu, missed: %llu }\n",
+			   prefix, nrs_deadline_class_names[i],
+			   stats->ds_dispatched[i], stats->ds_missed[i]);
+}
+
+/**
+ * Shows the number of requests handled by the deadline policy for each class,
+ * and how many of them started being handled after their deadline, for both
+ * the regular and high-priority NRS heads of a service.
+ */
+static int
+ptlrpc_lprocfs_nrs_deadline_stats_seq_show(struct seq_file *m, void *data)
+{
+	struct ptlrpc_service *svc = m->private;
+	struct nrs_deadline_stats stats;
+	int rc;
+
+	memset(&stats, 0, sizeof(stats));
+	rc = ptlrpc_nrs_policy_control(svc, PTLRPC_NRS_QUEUE_REG,
+				       NRS_POL_NAME_DEADLINE,
+				       NRS_CTL_DEADLINE_RD_STATS,
+				       false, &stats);
+	if (rc == 0)
+		nrs_deadline_stats_seq_print(m, "reg_", &stats);
+	else if (rc != -ENODEV)
+		return rc;
+
+	if (!nrs_svc_has_hp(svc))
+		return 0;
+
+	memset(&stats, 0, sizeof(stats));
+	rc = ptlrpc_nrs_policy_control(svc, PTLRPC_NRS_QUEUE_HP,
+				       NRS_POL_NAME_DEADLINE,
+				       NRS_CTL_DEADLINE_RD_STATS,
+				       false, &stats);
+	if (rc == 0)
+		nrs_deadline_stats_seq_print(m, "hp_", &stats);
+	else if (rc == -ENODEV)
+		rc = 0;
+
+	return rc;
+}
+LDEBUGFS_SEQ_FOPS_RO(ptlrpc_lprocfs_nrs_deadline_stats);
+
+static int nrs_deadline_lprocfs_init(struct ptlrpc_service *svc)
+{
+	struct lprocfs_vars nrs_deadline_lprocfs_vars[] = {
+		{ .name		= "nrs_deadline_boost",
+		  .fops		= &ptlrpc_lprocfs_nrs_deadline_boost_fops,
+		  .data		= svc },
+		{ .name		= "nrs_deadline_jobids",
+		  .fops		= &ptlrpc_lprocfs_nrs_deadline_jobids_fops,
+		  .data		= svc },
+		{ .name		= "nrs_deadline_stats",
+		  .fops		= &ptlrpc_lprocfs_nrs_deadline_stats_fops,
+		  .data		= svc },
+		{ NULL }
+	};
+
+	if (IS_ERR_OR_NULL(svc->srv_debugfs_entry))
+		return 0;
+
+	return ldebugfs_add_vars(svc->srv_debugfs_entry,
+				 nrs_deadline_lprocfs_vars, NULL);
+}
+
+/**
+ * Deadline policy operations
+ */
+static const struct ptlrpc_nrs_pol_ops nrs_deadline_ops = {
+	.op_policy_start	= nrs_deadline_start,
+	.op_policy_stop		= nrs_deadline_stop,
+	.op_policy_ctl		= nrs_deadline_ctl,
+	.op_res_get		= nrs_deadline_res_get,
+	.op_req_get		= nrs_deadline_req_get,
+	.op_req_enqueue		= nrs_deadline_req_add,
+	.op_req_dequeue		= nrs_deadline_req_del,
+	.op_req_stop		= nrs_deadline_req_stop,
+	.op_lprocfs_init	= nrs_deadline_lprocfs_init,
+};
+
+/**
+ * Deadline policy configuration
+ */
+struct ptlrpc_nrs_pol_conf nrs_conf_deadline = {
+	.nc_name		= NRS_POL_NAME_DEADLINE,
+	.nc_ops			= &nrs_deadline_ops,
+	.nc_compat		= nrs_policy_compat_all,
+};
+
+/** @} deadline */
+
+#endif /* HAVE_SERVER_SUPPORT */
+
+/** @} nrs */
@@ -124,6 +124,41 @@ nrs_tbf_cli_rule_put(struct nrs_tbf_client *cli)
 	cli->tc_rule = NULL;
 }
 
+static inline bool nrs_tbf_cli_may_borrow(struct nrs_tbf_client *cli)
+{
+	return (cli->tc_rule->tr_flags &
+		(NTRS_BORROW | NTRS_REALTIME | NTRS_STOPPING)) == NTRS_BORROW;
+}
+
+/**
+ * Adds a queued class to the borrow heap if its rule lets it borrow. A class
+ * idle for a while must not bank borrowing credit, so its tag starts no
+ * earlier than the current virtual time.
+ */
+static void nrs_tbf_borrow_add(struct nrs_tbf_head *head,
+			       struct nrs_tbf_client *cli)
+{
+	if (cli->tc_in_borrow_heap || !nrs_tbf_cli_may_borrow(cli))
+		return;
+
+	cli->tc_borrow_vtime = max(cli->tc_borrow_vtime,
+				   head->th_borrow_vtime);
+	/* on failure the class just does not borrow */
+	if (cfs_binheap_insert(head->th_borrow_heap,
+			       &cli->tc_borrow_node) == 0)
+		cli->tc_in_borrow_heap = true;
+}
+
+static void nrs_tbf_borrow_del(struct nrs_tbf_head *head,
+			       struct nrs_tbf_client *cli)
+{
+	if (!cli->tc_in_borrow_heap)
+		return;
+
+	cfs_binheap_remove(head->th_borrow_heap, &cli->tc_borrow_node);
+	cli->tc_in_borrow_heap = false;
+}
+
 static void
 nrs_tbf_cli_reset_value(struct nrs_tbf_head *head,
 			struct nrs_tbf_client *cli)
@@ -139,9 +174,12 @@ nrs_tbf_cli_reset_value(struct nrs_tbf_head *head,
 	cli->tc_rule_sequence = atomic_read(&head->th_rule_sequence);
 	cli->tc_rule_generation = rule->tr_generation;
 
-	if (cli->tc_in_heap)
+	if (cli->tc_in_heap) {
 		cfs_binheap_relocate(head->th_binheap,
 				     &cli->tc_node);
+		nrs_tbf_borrow_del(head, cli);
+		nrs_tbf_borrow_add(head, cli);
+	}
 }
 
 static void
@@ -271,6 +309,7 @@ nrs_tbf_cli_fini(struct nrs_tbf_client *cli)
 {
 	LASSERT(list_empty(&cli->tc_list));
 	LASSERT(!cli->tc_in_heap);
+	LASSERT(!cli->tc_in_borrow_heap);
 	LASSERT(atomic_read(&cli->tc_ref) == 0);
 	spin_lock(&cli->tc_rule_lock);
 	nrs_tbf_cli_rule_put(cli);
@@ -302,6 +341,9 @@ nrs_tbf_rule_start(struct ptlrpc_nrs_policy *policy,
 	memcpy(rule->tr_name, start->tc_name, strlen(start->tc_name));
 	rule->tr_rpc_rate = start->u.tc_start.ts_rpc_rate;
 	rule->tr_flags = start->u.tc_start.ts_rule_flags;
+	/* realtime rules already get their missed tokens back */
+	if (rule->tr_flags & NTRS_REALTIME)
+		rule->tr_flags &= ~NTRS_BORROW;
 	rule->tr_nsecs = NSEC_PER_SEC;
 	do_div(rule->tr_nsecs, rule->tr_rpc_rate);
 	rule->tr_depth = tbf_depth;
@@ -349,9 +391,11 @@ nrs_tbf_rule_start(struct ptlrpc_nrs_policy *policy,
 		LASSERT(head->th_rule == NULL);
 		head->th_rule = rule;
 	}
+	if (rule->tr_flags & NTRS_BORROW)
+		atomic_inc(&head->th_borrow_rules);
 
-	CDEBUG(D_RPCTRACE, "TBF starts rule@%p rate %llu gen %llu\n",
-	       rule, rule->tr_rpc_rate, rule->tr_generation);
+	CDEBUG(D_RPCTRACE, "TBF starts rule@%p rate %llu gen %llu flags %#x\n",
+	       rule, rule->tr_rpc_rate, rule->tr_generation, rule->tr_flags);
 
 	return 0;
 }
@@ -469,6 +513,8 @@ nrs_tbf_rule_stop(struct ptlrpc_nrs_policy *policy,
 
 	list_del_init(&rule->tr_linkage);
 	rule->tr_flags |= NTRS_STOPPING;
+	if (rule->tr_flags & NTRS_BORROW)
+		atomic_dec(&head->th_borrow_rules);
 	nrs_tbf_rule_put(rule);
 	nrs_tbf_rule_put(rule);
 
@@ -546,6 +592,42 @@ static struct cfs_binheap_ops nrs_tbf_heap_ops = {
 	.hop_compare	= tbf_cli_compare,
 };
 
+/**
+ * Borrow heap predicate, the class with the smallest borrowing tag first.
+ *
+ * \param[in] e1 the first binheap node to compare
+ * \param[in] e2 the second binheap node to compare
+ *
+ * \retval 0 e1 > e2
+ * \retval 1 e1 < e2
+ */
+static int
+tbf_cli_borrow_compare(struct cfs_binheap_node *e1,
+		       struct cfs_binheap_node *e2)
+{
+	struct nrs_tbf_client *cli1;
+	struct nrs_tbf_client *cli2;
+
+	cli1 = container_of(e1, struct nrs_tbf_client, tc_borrow_node);
+	cli2 = container_of(e2, struct nrs_tbf_client, tc_borrow_node);
+
+	if (cli1->tc_borrow_vtime < cli2->tc_borrow_vtime)
+		return 1;
+	else if (cli1->tc_borrow_vtime > cli2->tc_borrow_vtime)
+		return 0;
+
+	return cli1->tc_check_time <= cli2->tc_check_time;
+}
+
+/**
+ * TBF borrow heap operations
+ */
+static struct cfs_binheap_ops nrs_tbf_borrow_heap_ops = {
+	.hop_enter	= NULL,
+	.hop_exit	= NULL,
+	.hop_compare	= tbf_cli_borrow_compare,
+};
+
 static unsigned nrs_tbf_jobid_hop_hash(struct cfs_hash *hs, const void *key,
 				  unsigned mask)
 {
@@ -838,7 +920,7 @@ nrs_tbf_jobid_list_add(struct cfs_lstr *id, struct list_head *jobid_list)
 	return 0;
 }
 
-static bool
+bool
 cfs_match_wildcard(const char *pattern, const char *content)
 {
 	if (*pattern == '\0' && *content == '\0')
@@ -2801,7 +2883,15 @@ static int nrs_tbf_start(struct ptlrpc_nrs_policy *policy, char *arg)
 	if (head->th_binheap == NULL)
 		GOTO(out_free_head, rc = -ENOMEM);
 
+	head->th_borrow_heap = cfs_binheap_create(&nrs_tbf_borrow_heap_ops,
+						  CBH_FLAG_ATOMIC_GROW, 4096,
+						  NULL, nrs_pol2cptab(policy),
+						  nrs_pol2cptid(policy));
+	if (head->th_borrow_heap == NULL)
+		GOTO(out_free_heap, rc = -ENOMEM);
+
 	atomic_set(&head->th_rule_sequence, 0);
+	atomic_set(&head->th_borrow_rules, 0);
 	spin_lock_init(&head->th_rule_lock);
 	INIT_LIST_HEAD(&head->th_list);
 	hrtimer_init(&head->th_timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
@@ -2813,6 +2903,8 @@ static int nrs_tbf_start(struct ptlrpc_nrs_policy *policy, char *arg)
 	policy->pol_private = head;
 	return 0;
 out_free_heap:
+	if (head->th_borrow_heap != NULL)
+		cfs_binheap_destroy(head->th_borrow_heap);
 	cfs_binheap_destroy(head->th_binheap);
 out_free_head:
 	OBD_FREE_PTR(head);
@@ -2848,6 +2940,8 @@ static void nrs_tbf_stop(struct ptlrpc_nrs_policy *policy)
 	LASSERT(head->th_binheap != NULL);
 	LASSERT(cfs_binheap_is_empty(head->th_binheap));
 	cfs_binheap_destroy(head->th_binheap);
+	LASSERT(cfs_binheap_is_empty(head->th_borrow_heap));
+	cfs_binheap_destroy(head->th_borrow_heap);
 	OBD_FREE_PTR(head);
 	nrs->nrs_throttling = 0;
 	wake_up(&policy->pol_nrs->nrs_svcpt->scp_waitq);
@@ -3028,6 +3122,76 @@ static void nrs_tbf_res_put(struct ptlrpc_nrs_policy *policy,
 	head->th_ops->o_cli_put(head, cli);
 }
 
+/**
+ * Dispatches a request on spare capacity.
+ *
+ * Called when no class has a token left. Rather than idling the service
+ * until the earliest token arrives, a request of a class whose rule was
+ * started with "borrow=1" is handled without consuming any token, so the
+ * rate of such a rule is a guaranteed minimum rather than a hard limit.
+ * Spare capacity is shared among borrowing classes in proportion to their
+ * rates by a start-time fair queueing tag: each borrowed request advances
+ * the class tag by its token interval, and the class with the smallest tag
+ * borrows next. The token bucket of the class is left untouched, so
+ * borrowing never eats into the guaranteed rate of any class.
+ *
+ * Queued classes which may borrow are kept in nrs_tbf_head::th_borrow_heap
+ * ordered by tag, so that picking one does not scan all the classes under
+ * the request lock.
+ *
+ * \param[in] head	the TBF policy instance
+ *
+ * \retval the borrowed request, or NULL if no queued class may borrow
+ */
+static struct ptlrpc_nrs_request *
+nrs_tbf_borrow_get(struct nrs_tbf_head *head)
+{
+	struct nrs_tbf_client *best = NULL;
+	struct ptlrpc_nrs_request *nrq;
+	struct cfs_binheap_node *node;
+	__u64 best_tag;
+
+	if (atomic_read(&head->th_borrow_rules) == 0)
+		return NULL;
+
+	while ((node = cfs_binheap_root(head->th_borrow_heap)) != NULL) {
+		best = container_of(node, struct nrs_tbf_client,
+				    tc_borrow_node);
+		if (nrs_tbf_cli_may_borrow(best))
+			break;
+		/* the rule was stopped since the class was queued */
+		nrs_tbf_borrow_del(head, best);
+	}
+
+	if (node == NULL)
+		return NULL;
+
+	LASSERT(best->tc_in_heap);
+	best_tag = max(best->tc_borrow_vtime, head->th_borrow_vtime);
+	head->th_borrow_vtime = best_tag;
+	best->tc_borrow_vtime = best_tag + best->tc_nsecs;
+
+	nrq = list_entry(best->tc_list.next, struct ptlrpc_nrs_request,
+			 nr_u.tbf.tr_list);
+	list_del_init(&nrq->nr_u.tbf.tr_list);
+	if (list_empty(&best->tc_list)) {
+		cfs_binheap_remove(head->th_binheap, &best->tc_node);
+		best->tc_in_heap = false;
+		nrs_tbf_borrow_del(head, best);
+	} else {
+		cfs_binheap_relocate(head->th_borrow_heap,
+				     &best->tc_borrow_node);
+	}
+
+	CDEBUG(D_RPCTRACE,
+	       "TBF borrows: class@%p rate %llu gen %llu tag %llu, rule@%p rate %llu gen %llu\n",
+	       best, best->tc_rpc_rate, best->tc_rule_generation, best_tag,
+	       best->tc_rule, best->tc_rule->tr_rpc_rate,
+	       best->tc_rule->tr_generation);
+
+	return nrq;
+}
+
 /**
  * Called when getting a request from the TBF policy for handling, or just
  * peeking; removes the request from the policy when it is to be handled.
@@ -3112,6 +3276,7 @@ struct ptlrpc_nrs_request *nrs_tbf_req_get(struct ptlrpc_nrs_policy *policy,
 				cfs_binheap_remove(head->th_binheap,
 						   &cli->tc_node);
 				cli->tc_in_heap = false;
+				nrs_tbf_borrow_del(head, cli);
 			} else {
 				if (!(rule->tr_flags & NTRS_REALTIME))
 					cli->tc_deadline = now + cli->tc_nsecs;
@@ -3137,6 +3302,11 @@ struct ptlrpc_nrs_request *nrs_tbf_req_get(struct ptlrpc_nrs_policy *policy,
 					return nrs_tbf_req_get(policy,
 							       peek, force);
 			}
+
+			nrq = nrs_tbf_borrow_get(head);
+			if (nrq != NULL)
+				return nrq;
+
 			policy->pol_nrs->nrs_throttling = 1;
 			head->th_deadline = deadline;
 			time = ktime_set(0, 0);
@@ -3176,10 +3346,15 @@ static int nrs_tbf_req_add(struct ptlrpc_nrs_policy *policy,
 		rc = cfs_binheap_insert(head->th_binheap, &cli->tc_node);
 		if (rc == 0) {
 			cli->tc_in_heap = true;
+			nrs_tbf_borrow_add(head, cli);
 			nrq->nr_u.tbf.tr_sequence = head->th_sequence++;
 			list_add_tail(&nrq->nr_u.tbf.tr_list,
 					  &cli->tc_list);
-			if (policy->pol_nrs->nrs_throttling) {
+			if (policy->pol_nrs->nrs_throttling &&
+			    nrs_tbf_cli_may_borrow(cli)) {
+				/* spare capacity can be lent right now */
+				policy->pol_nrs->nrs_throttling = 0;
+			} else if (policy->pol_nrs->nrs_throttling) {
 				__u64 deadline = cli->tc_deadline;
 				if ((head->th_deadline > deadline) &&
 				    (hrtimer_try_to_cancel(&head->th_timer)
@@ -3237,6 +3412,7 @@ static void nrs_tbf_req_del(struct ptlrpc_nrs_policy *policy,
 		cfs_binheap_remove(head->th_binheap,
 				   &cli->tc_node);
 		cli->tc_in_heap = false;
+		nrs_tbf_borrow_del(head, cli);
 	} else {
 		cfs_binheap_relocate(head->th_binheap,
 				     &cli->tc_node);
@@ -3446,6 +3622,18 @@ nrs_tbf_parse_value_pair(struct nrs_tbf_cmd *cmd, char *buffer)
 
 		if (realtime > 0)
 			cmd->u.tc_start.ts_rule_flags |= NTRS_REALTIME;
+	} else if (strcmp(key, "borrow") == 0) {
+		unsigned long borrow;
+
+		if (cmd->tc_cmd != NRS_CTL_TBF_START_RULE)
+			return -EINVAL;
+
+		rc = kstrtoul(val, 10, &borrow);
+		if (rc)
+			return rc;
+
+		if (borrow > 0)
+			cmd->u.tc_start.ts_rule_flags |= NTRS_BORROW;
 	} else {
 		return -EINVAL;
 	}
@@ -52,6 +52,10 @@ extern struct ptlrpc_nrs_pol_conf nrs_conf_orr;
 extern struct ptlrpc_nrs_pol_conf nrs_conf_trr;
 extern struct ptlrpc_nrs_pol_conf nrs_conf_tbf;
 extern struct ptlrpc_nrs_pol_conf nrs_conf_delay;
+extern struct ptlrpc_nrs_pol_conf nrs_conf_deadline;
+
+/* nrs_tbf.c */
+bool cfs_match_wildcard(const char *pattern, const char *content);
 #endif /* HAVE_SERVER_SUPPORT */
 
 /**
@@ -114,11 +118,17 @@ void ptlrpc_ldebugfs_register_service(struct dentry *debugfs_entry,
 #ifdef CONFIG_PROC_FS
 void ptlrpc_lprocfs_unregister_service(struct ptlrpc_service *svc);
 void ptlrpc_lprocfs_rpc_sent(struct ptlrpc_request *req, long amount);
+void ptlrpc_lprocfs_rpc_done(struct ptlrpc_request *req);
+void ptlrpc_lprocfs_srv_latency(struct ptlrpc_service *svc,
+				struct ptlrpc_request *req,
+				s64 wait_usecs, s64 handle_usecs);
 void ptlrpc_lprocfs_do_request_stat (struct ptlrpc_request *req,
                                      long q_usec, long work_usec);
 #else
 #define ptlrpc_lprocfs_unregister_service(params...) do{}while(0)
 #define ptlrpc_lprocfs_rpc_sent(params...) do{}while(0)
+#define ptlrpc_lprocfs_rpc_done(params...) do{}while(0)
+#define ptlrpc_lprocfs_srv_latency(params...) do{}while(0)
 #define ptlrpc_lprocfs_do_request_stat(params...) do{}while(0)
 #endif /* CONFIG_PROC_FS */
 
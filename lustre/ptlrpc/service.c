@@ -789,6 +789,9 @@ ptlrpc_register_service(struct ptlrpc_service_conf *conf,
 	service->srv_ctx_tags		= conf->psc_thr.tc_ctx_tags;
 	service->srv_hpreq_ratio	= PTLRPC_SVC_HP_RATIO;
 	service->srv_ops		= conf->psc_ops;
+	service->srv_nthrs_idle_timeout	= PTLRPC_NTHRS_IDLE_TIMEOUT;
+	service->srv_nthrs_rebalance	= true;
+	atomic_set(&service->srv_nthrs_total, 0);
 
 	for (i = 0; i < ncpts; i++) {
 		if (!cconf->cc_affinity)
@@ -2198,6 +2201,9 @@ put_conn:
 					    timediff_usecs);
 		}
 	}
+	ptlrpc_lprocfs_srv_latency(svc, request,
+				   arrived_usecs - timediff_usecs,
+				   timediff_usecs);
 	if (unlikely(request->rq_early_count)) {
 		DEBUG_REQ(D_ADAPTTO, request,
 			  "sent %d early replies before finishing in %llds",
@@ -2403,6 +2409,65 @@ ptlrpc_threads_enough(struct ptlrpc_service_part *svcpt)
 	       (svcpt->scp_service->srv_ops.so_hpreq_handler != NULL);
 }
 
+/**
+ * Whether a partition which already has srv_nthrs_cpt_limit threads may
+ * borrow the unused thread quota of other partitions.
+ *
+ * One partition never grows beyond twice its own limit. Other partitions
+ * are read without their locks, this is only a heuristic, threads_max is
+ * enforced by ptlrpc_threads_reserve(). The borrowed threads go away through
+ * the idle timeout once the backlog has been drained, which returns the
+ * quota to its owner.
+ */
+static int ptlrpc_threads_borrowable(struct ptlrpc_service_part *svcpt,
+				     int nthrs)
+{
+	struct ptlrpc_service *svc = svcpt->scp_service;
+	struct ptlrpc_service_part *tmp;
+	int total = 0;
+	int i;
+
+	if (!svc->srv_nthrs_rebalance || svc->srv_ncpts == 1 ||
+	    nthrs >= 2 * svc->srv_nthrs_cpt_limit)
+		return 0;
+
+	/* only a partition with a backlog deserves help */
+	if (svcpt->scp_nreqs_incoming == 0 &&
+	    svcpt->scp_nrs_reg.nrs_req_queued == 0)
+		return 0;
+
+	ptlrpc_service_for_each_part(tmp, i, svc)
+		total += tmp->scp_nthrs_running + tmp->scp_nthrs_starting;
+
+	return total < svc->srv_nthrs_cpt_limit * svc->srv_ncpts;
+}
+
+/**
+ * Reserves one thread of the service-wide srv_nthrs_cpt_limit * srv_ncpts,
+ * so that threads_max stays a hard limit even when partitions borrow each
+ * other's quota. Released by ptlrpc_threads_release().
+ */
+static bool ptlrpc_threads_reserve(struct ptlrpc_service *svc)
+{
+	int limit = svc->srv_nthrs_cpt_limit * svc->srv_ncpts;
+	int old = atomic_read(&svc->srv_nthrs_total);
+	int cur;
+
+	while (old < limit) {
+		cur = atomic_cmpxchg(&svc->srv_nthrs_total, old, old + 1);
+		if (cur == old)
+			return true;
+		old = cur;
+	}
+
+	return false;
+}
+
+static inline void ptlrpc_threads_release(struct ptlrpc_service *svc)
+{
+	atomic_dec(&svc->srv_nthrs_total);
+}
+
 /**
  * allowed to create more threads
  * user can call it w/o any lock but need to hold
@@ -2411,9 +2476,10 @@ ptlrpc_threads_enough(struct ptlrpc_service_part *svcpt)
 static inline int
 ptlrpc_threads_increasable(struct ptlrpc_service_part *svcpt)
 {
-	return svcpt->scp_nthrs_running +
-	       svcpt->scp_nthrs_starting <
-	       svcpt->scp_service->srv_nthrs_cpt_limit;
+	int nthrs = svcpt->scp_nthrs_running + svcpt->scp_nthrs_starting;
+
+	return nthrs < svcpt->scp_service->srv_nthrs_cpt_limit ||
+	       ptlrpc_threads_borrowable(svcpt, nthrs);
 }
 
 /**
@@ -2457,20 +2523,73 @@ ptlrpc_server_request_incoming(struct ptlrpc_service_part *svcpt)
 	return !list_empty(&svcpt->scp_req_incoming);
 }
 
+/**
+ * Takes an idle thread out of service if the partition has more threads
+ * than it needs.
+ *
+ * Called by a thread which has found nothing to do for a whole
+ * srv_nthrs_idle_timeout. The running count is dropped here under scp_lock,
+ * so that threads timing out together never shrink the partition below
+ * srv_nthrs_cpt_init.
+ *
+ * \retval true if the thread must exit
+ */
+static bool ptlrpc_thread_idle_exit(struct ptlrpc_service_part *svcpt,
+				    struct ptlrpc_thread *thread)
+{
+	struct ptlrpc_service *svc = svcpt->scp_service;
+	bool exit = false;
+
+	spin_lock(&svcpt->scp_lock);
+	if (svc->srv_nthrs_idle_timeout > 0 && !ptlrpc_thread_stopping(thread) &&
+	    svcpt->scp_nthrs_running > svc->srv_nthrs_cpt_init &&
+	    !ptlrpc_server_request_incoming(svcpt) &&
+	    !ptlrpc_server_request_pending(svcpt, false)) {
+		thread_clear_flags(thread, SVC_RUNNING);
+		svcpt->scp_nthrs_running--;
+		ptlrpc_threads_release(svc);
+		exit = true;
+	}
+	spin_unlock(&svcpt->scp_lock);
+
+	if (exit)
+		CDEBUG(D_RPCTRACE, "%s: idle thread %s exits, %d left\n",
+		       svc->srv_name, thread->t_name,
+		       svcpt->scp_nthrs_running);
+	return exit;
+}
+
 static __attribute__((__noinline__)) int
 ptlrpc_wait_event(struct ptlrpc_service_part *svcpt,
 		  struct ptlrpc_thread *thread)
 {
+	struct ptlrpc_service *svc = svcpt->scp_service;
 	/* Don't exit while there are replies to be handled */
 	struct l_wait_info lwi = LWI_TIMEOUT(svcpt->scp_rqbd_timeout,
 					     ptlrpc_retry_rqbds, svcpt);
+	int idle_timeout = READ_ONCE(svc->srv_nthrs_idle_timeout);
+	bool idle_wait = false;
+	int rc;
 
 	lc_watchdog_disable(thread->t_watchdog);
 
 	cond_resched();
 
-	l_wait_event_exclusive_head(svcpt->scp_waitq,
+	/* extra threads wake up now and then to see if they are still needed,
+	 * the exclusive head wakeup keeps the same threads busy and lets the
+	 * others time out */
+	if (svcpt->scp_rqbd_timeout == 0 && idle_timeout > 0 &&
+	    svcpt->scp_nthrs_running > svc->srv_nthrs_cpt_init) {
+		lwi = LWI_TIMEOUT(cfs_time_seconds(idle_timeout), NULL, NULL);
+		idle_wait = true;
+	}
+
+	/* a new threads_idle_timeout ends the wait, see
+	 * threads_idle_timeout_store(), so that it is used right away */
+	rc = l_wait_event_exclusive_head(svcpt->scp_waitq,
 				ptlrpc_thread_stopping(thread) ||
+				READ_ONCE(svc->srv_nthrs_idle_timeout) !=
+				idle_timeout ||
 				ptlrpc_server_request_incoming(svcpt) ||
 				ptlrpc_server_request_pending(svcpt, false) ||
 				ptlrpc_rqbd_pending(svcpt) ||
@@ -2479,6 +2598,10 @@ ptlrpc_wait_event(struct ptlrpc_service_part *svcpt,
 	if (ptlrpc_thread_stopping(thread))
 		return -EINTR;
 
+	if (idle_wait && rc == -ETIMEDOUT &&
+	    ptlrpc_thread_idle_exit(svcpt, thread))
+		return -ETIMEDOUT;
+
 	lc_watchdog_touch(thread->t_watchdog,
 			  ptlrpc_server_get_timeout(svcpt));
 	return 0;
@@ -2499,6 +2622,8 @@ static int ptlrpc_main(void *arg)
 	struct group_info *ginfo = NULL;
 	struct lu_env *env;
 	int counter = 0, rc = 0;
+	bool idle_exit = false;
+	bool reap = false;
 	ENTRY;
 
 	thread->t_pid = current_pid();
@@ -2591,8 +2716,12 @@ static int ptlrpc_main(void *arg)
 
 	/* XXX maintain a list of all managed devices: insert here */
 	while (!ptlrpc_thread_stopping(thread)) {
-		if (ptlrpc_wait_event(svcpt, thread))
+		int err = ptlrpc_wait_event(svcpt, thread);
+
+		if (err != 0) {
+			idle_exit = err == -ETIMEDOUT;
 			break;
+		}
 
 		ptlrpc_check_rqbd_pool(svcpt);
 
@@ -2638,6 +2767,21 @@ static int ptlrpc_main(void *arg)
         lc_watchdog_delete(thread->t_watchdog);
         thread->t_watchdog = NULL;
 
+	if (idle_exit) {
+		/* shrink the reply state pool along with the threads */
+		spin_lock(&svcpt->scp_rep_lock);
+		if (!list_empty(&svcpt->scp_rep_idle)) {
+			rs = list_entry(svcpt->scp_rep_idle.next,
+					struct ptlrpc_reply_state, rs_list);
+			list_del(&rs->rs_list);
+		} else {
+			rs = NULL;
+		}
+		spin_unlock(&svcpt->scp_rep_lock);
+		if (rs != NULL)
+			OBD_FREE_LARGE(rs, svc->srv_max_reply_size);
+	}
+
 out_srv_fini:
         /*
          * deconstruct service specific state created by ptlrpc_start_thread()
@@ -2654,20 +2798,34 @@ out:
                thread, thread->t_pid, thread->t_id, rc);
 
 	spin_lock(&svcpt->scp_lock);
-	if (thread_test_and_clear_flags(thread, SVC_STARTING))
+	if (thread_test_and_clear_flags(thread, SVC_STARTING)) {
 		svcpt->scp_nthrs_starting--;
+		ptlrpc_threads_release(svc);
+	}
 
 	if (thread_test_and_clear_flags(thread, SVC_RUNNING)) {
 		/* must know immediately */
 		svcpt->scp_nthrs_running--;
+		ptlrpc_threads_release(svc);
 	}
 
 	thread->t_id = rc;
 	thread_add_flags(thread, SVC_STOPPED);
 
+	/* Nobody waits for a thread which exited because it was idle, so it
+	 * has to free itself, unless ptlrpc_svcpt_stop_threads() has already
+	 * flagged it and will wait for it. */
+	if (idle_exit && !thread_is_stopping(thread)) {
+		list_del(&thread->t_link);
+		reap = true;
+	}
+
 	wake_up(&thread->t_ctl_waitq);
 	spin_unlock(&svcpt->scp_lock);
 
+	if (reap)
+		OBD_FREE_PTR(thread);
+
 	return rc;
 }
 
@@ -2950,6 +3108,12 @@ int ptlrpc_start_thread(struct ptlrpc_service_part *svcpt, int wait)
 		RETURN(-EAGAIN);
 	}
 
+	if (!ptlrpc_threads_reserve(svc)) {
+		spin_unlock(&svcpt->scp_lock);
+		OBD_FREE_PTR(thread);
+		RETURN(-EMFILE);
+	}
+
 	svcpt->scp_nthrs_starting++;
 	thread->t_id = svcpt->scp_thr_nextid++;
 	thread_add_flags(thread, SVC_STARTING);
@@ -2974,6 +3138,7 @@ int ptlrpc_start_thread(struct ptlrpc_service_part *svcpt, int wait)
 		       thread->t_name, rc);
 		spin_lock(&svcpt->scp_lock);
 		--svcpt->scp_nthrs_starting;
+		ptlrpc_threads_release(svc);
 		if (thread_is_stopping(thread)) {
 			/* this ptlrpc_thread is being hanled
 			 * by ptlrpc_svcpt_stop_threads now
@@ -0,0 +1,291 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License version 2 for more details (a copy is included
+ * in the LICENSE file that accompanied this code).
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; If not, see
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * GPL HEADER END
+ */
+
+/* Measure the cost of LDLM resource lookups from 1, 16 and 64 kthreads.
+ * A private client namespace is filled with resources which are then
+ * looked up at random, once through ldlm_resource_get(), which uses the
+ * lockless RCU index, and once through the locked ns_rs_hash lookup alone
+ * for comparison. A last pass creates and drops resources that are not in
+ * the namespace, to measure the cost of keeping both indexes up to date. */
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/completion.h>
+#include <linux/kthread.h>
+#include <linux/ktime.h>
+
+#include <obd_class.h>
+#include <lustre_dlm.h>
+
+/* Random ID passed by userspace, and printed in messages, used to
+ * separate different runs of that module. */
+static int run_id;
+module_param(run_id, int, 0644);
+MODULE_PARM_DESC(run_id, "run ID");
+
+static int nres = 4096;
+module_param(nres, int, 0644);
+MODULE_PARM_DESC(nres, "number of resources in the namespace");
+
+static int nlookups = 100000;
+module_param(nlookups, int, 0644);
+MODULE_PARM_DESC(nlookups, "number of lookups per thread");
+
+#define PREFIX "lustre_kldlm_res_%u:"
+
+#define KLDLM_RES_MAX_THREADS	64
+
+enum kldlm_res_mode {
+	KLDLM_RES_RCU,
+	KLDLM_RES_LOCKED,
+	KLDLM_RES_CHURN,
+};
+
+static const char * const kldlm_res_mode_names[] = {
+	[KLDLM_RES_RCU]		= "rcu",
+	[KLDLM_RES_LOCKED]	= "locked",
+	[KLDLM_RES_CHURN]	= "create",
+};
+
+struct kldlm_res_bench {
+	struct ldlm_namespace	*krb_ns;
+	enum kldlm_res_mode	 krb_mode;
+	struct completion	 krb_start;
+	struct completion	 krb_done;
+	atomic_t		 krb_running;
+	atomic_t		 krb_errors;
+};
+
+/* ns_obd is only used by the client pool to read the server SLV */
+static struct obd_device kldlm_res_obd;
+
+static void kldlm_res_name(struct ldlm_res_id *id, u64 i)
+{
+	memset(id, 0, sizeof(*id));
+	id->name[0] = i + 1;
+	id->name[1] = run_id;
+}
+
+static int kldlm_res_lookup(struct kldlm_res_bench *krb, u64 i)
+{
+	struct ldlm_namespace *ns = krb->krb_ns;
+	struct ldlm_resource *res;
+	struct ldlm_res_id id;
+
+	kldlm_res_name(&id, i);
+	switch (krb->krb_mode) {
+	case KLDLM_RES_RCU:
+		res = ldlm_resource_get(ns, NULL, &id, LDLM_EXTENT, 0);
+		break;
+	case KLDLM_RES_LOCKED:
+		res = cfs_hash_lookup(ns->ns_rs_hash, &id);
+		if (res == NULL)
+			res = ERR_PTR(-ENOENT);
+		break;
+	case KLDLM_RES_CHURN:
+	default:
+		/* outside of the populated range, so created and freed */
+		kldlm_res_name(&id, nres + i);
+		res = ldlm_resource_get(ns, NULL, &id, LDLM_EXTENT, 1);
+		break;
+	}
+	if (IS_ERR(res))
+		return PTR_ERR(res);
+
+	ldlm_resource_putref(res);
+	return 0;
+}
+
+static int kldlm_res_thread(void *data)
+{
+	struct kldlm_res_bench *krb = data;
+	u32 seed = (uintptr_t)current ^ run_id;
+	int i;
+
+	wait_for_completion(&krb->krb_start);
+
+	for (i = 0; i < nlookups; i++) {
+		seed = seed * 1103515245 + 12345;
+		if (kldlm_res_lookup(krb, (seed >> 8) % nres) != 0)
+			atomic_inc(&krb->krb_errors);
+	}
+
+	if (atomic_dec_and_test(&krb->krb_running))
+		complete(&krb->krb_done);
+
+	/* Wait for call to kthread_stop. */
+	set_current_state(TASK_INTERRUPTIBLE);
+	while (!kthread_should_stop()) {
+		schedule();
+		set_current_state(TASK_INTERRUPTIBLE);
+	}
+	set_current_state(TASK_RUNNING);
+
+	return 0;
+}
+
+static int kldlm_res_run(struct ldlm_namespace *ns, enum kldlm_res_mode mode,
+			 int nthreads)
+{
+	struct task_struct *thr[KLDLM_RES_MAX_THREADS];
+	struct kldlm_res_bench krb;
+	ktime_t start;
+	u64 total;
+	u64 ns_per_op;
+	s64 us;
+	int rc = 0;
+	int i;
+
+	krb.krb_ns = ns;
+	krb.krb_mode = mode;
+	init_completion(&krb.krb_start);
+	init_completion(&krb.krb_done);
+	atomic_set(&krb.krb_running, nthreads);
+	atomic_set(&krb.krb_errors, 0);
+
+	for (i = 0; i < nthreads; i++) {
+		thr[i] = kthread_run(kldlm_res_thread, &krb, "kldlm_res_%u_%d",
+				     run_id, i);
+		if (IS_ERR(thr[i])) {
+			rc = PTR_ERR(thr[i]);
+			pr_err(PREFIX " cannot create kthread: %d\n",
+			       run_id, rc);
+			break;
+		}
+	}
+
+	/* let the threads which were started run and exit cleanly */
+	if (rc != 0)
+		atomic_sub(nthreads - i, &krb.krb_running);
+	nthreads = i;
+
+	start = ktime_get();
+	complete_all(&krb.krb_start);
+	if (nthreads > 0)
+		wait_for_completion(&krb.krb_done);
+	us = ktime_us_delta(ktime_get(), start);
+
+	for (i = 0; i < nthreads; i++)
+		kthread_stop(thr[i]);
+
+	if (rc != 0)
+		return rc;
+
+	if (atomic_read(&krb.krb_errors) != 0) {
+		pr_err(PREFIX " %s: %d lookups failed\n", run_id,
+		       kldlm_res_mode_names[mode],
+		       atomic_read(&krb.krb_errors));
+		return -EIO;
+	}
+
+	total = (u64)nthreads * nlookups;
+	ns_per_op = div64_u64(max_t(s64, us, 1) * NSEC_PER_USEC * nthreads,
+			      total);
+	pr_info(PREFIX " %s: threads %d lookups %llu time %lldus %llu ops/s %llu ns/op\n",
+		run_id, kldlm_res_mode_names[mode], nthreads, total, us,
+		div64_u64(total * USEC_PER_SEC, max_t(s64, us, 1)),
+		ns_per_op);
+
+	return 0;
+}
+
+static int __init kldlm_res_init(void)
+{
+	static const int threads[] = { 1, 16, 64 };
+	struct ldlm_resource **res = NULL;
+	struct ldlm_namespace *ns;
+	struct ldlm_res_id id;
+	char name[32];
+	int rc = 0;
+	int mode;
+	int i;
+
+	if (nres < 1 || nlookups < 1) {
+		pr_err(PREFIX " invalid nres %d or nlookups %d\n",
+		       run_id, nres, nlookups);
+		goto out;
+	}
+
+	rwlock_init(&kldlm_res_obd.obd_pool_lock);
+	snprintf(kldlm_res_obd.obd_name, sizeof(kldlm_res_obd.obd_name),
+		 "kldlm_res_%u", run_id);
+	snprintf(name, sizeof(name), "kldlm_res_%u", run_id);
+
+	ns = ldlm_namespace_new(&kldlm_res_obd, name, LDLM_NAMESPACE_CLIENT,
+				LDLM_NAMESPACE_GREEDY, LDLM_NS_TYPE_OSC);
+	if (ns == NULL) {
+		pr_err(PREFIX " cannot create namespace\n", run_id);
+		goto out;
+	}
+
+	/* hold a reference on every resource, so they stay in the
+	 * namespace while being looked up */
+	OBD_ALLOC_LARGE(res, nres * sizeof(*res));
+	if (res == NULL) {
+		pr_err(PREFIX " cannot allocate %d resources\n", run_id, nres);
+		goto out_ns;
+	}
+
+	for (i = 0; i < nres; i++) {
+		kldlm_res_name(&id, i);
+		res[i] = ldlm_resource_get(ns, NULL, &id, LDLM_EXTENT, 1);
+		if (IS_ERR(res[i])) {
+			rc = PTR_ERR(res[i]);
+			res[i] = NULL;
+			pr_err(PREFIX " cannot create resource %d: %d\n",
+			       run_id, i, rc);
+			goto out_res;
+		}
+	}
+
+	for (mode = KLDLM_RES_RCU; mode <= KLDLM_RES_CHURN; mode++) {
+		for (i = 0; i < ARRAY_SIZE(threads); i++) {
+			rc = kldlm_res_run(ns, mode, threads[i]);
+			if (rc != 0)
+				goto out_res;
+		}
+	}
+
+	pr_info(PREFIX " done\n", run_id);
+
+out_res:
+	for (i = 0; i < nres && res[i] != NULL; i++)
+		ldlm_resource_putref(res[i]);
+	OBD_FREE_LARGE(res, nres * sizeof(*res));
+out_ns:
+	ldlm_namespace_free(ns, NULL, 1);
+out:
+	/* Don't load. */
+	return -EINVAL;
+}
+
+static void __exit kldlm_res_exit(void)
+{
+}
+
+MODULE_AUTHOR("OpenSFS, Inc. <http://www.lustre.org/>");
+MODULE_DESCRIPTION("Lustre LDLM resource lookup benchmark module");
+MODULE_VERSION(LUSTRE_VERSION_STRING);
+MODULE_LICENSE("GPL");
+
+module_init(kldlm_res_init);
+module_exit(kldlm_res_exit);
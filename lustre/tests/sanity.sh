@@ -7286,6 +7286,48 @@ test_77k() { # LU-10906
 }
 run_test 77k "enable/disable checksum correctly"
 
+test_77l() {
+	[ $PARALLEL == "yes" ] && skip "skip parallel run"
+	$GSS && skip_env "could not run with gss"
+
+	local param=/sys/module/osc/parameters/osc_cksum_ptask_pages
+	[ -w $param ] || skip "no osc_cksum_ptask_pages parameter"
+
+	local t10_types=$(echo $CKSUM_TYPES | tr ' ' '\n' | grep t10)
+	[ -n "$t10_types" ] || skip "no T10-PI checksum types"
+	[ $(nproc) -gt 1 ] || skip_env "needs more than one CPU"
+	[ $(get_page_size client) -eq 4096 ] ||
+		skip_env "needs 4KB client pages for 1MB RPCs to qualify"
+
+	local old_pages=$(cat $param)
+	local old_debug=$($LCTL get_param -n debug)
+	local nrpcs
+
+	[ ! -f $F77_TMP ] && setup_f77
+	stack_trap "echo $old_pages > $param" EXIT
+	stack_trap "$LCTL set_param -n debug='$old_debug'" EXIT
+	# every RPC of more than one 64-page chunk, so 1MB RPCs qualify
+	echo 1 > $param
+	$LCTL set_param debug=+info
+	set_checksums 1
+	for f in $t10_types; do
+		set_checksum_type $f
+		$LCTL clear
+		dd if=$F77_TMP of=$DIR/$tfile bs=4M count=$((F77SZ / 4)) \
+			oflag=direct || error "dd write error with $f"
+		nrpcs=$($LCTL dk | grep -c "T10-PI guards of .* in parallel")
+		echo "$f: $nrpcs RPCs checksummed in parallel"
+		[ $nrpcs -gt 0 ] ||
+			error "no parallel T10-PI checksum with $f"
+		cancel_lru_locks osc
+		cmp $F77_TMP $DIR/$tfile || error "compare failed with $f"
+	done
+	set_checksum_type $ORIG_CSUM_TYPE
+	set_checksums 0
+	rm -f $DIR/$tfile
+}
+run_test 77l "parallel T10-PI checksum of large RPCs"
+
 [ "$ORIG_CSUM" ] && set_checksums $ORIG_CSUM || true
 rm -f $F77_TMP
 unset F77_TMP
@@ -7918,6 +7960,35 @@ test_101g() {
 }
 run_test 101g "Big bulk(4/16 MiB) readahead"
 
+test_101h() {
+	$LCTL get_param -n llite.*.read_ahead_async_file_threshold_mb \
+		> /dev/null 2>&1 || skip "no async readahead support"
+
+	local file=$DIR/$tfile
+	local old_threshold=$($LCTL get_param -n \
+		llite.*.read_ahead_async_file_threshold_mb | head -n 1)
+	local async
+
+	$LFS setstripe -c 1 -i 0 $file || error "setstripe $file failed"
+	dd if=/dev/zero of=$file bs=1M count=128 ||
+		error "dd to $file failed"
+	cancel_lru_locks osc
+
+	$LCTL set_param -n llite.*.read_ahead_async_file_threshold_mb=1
+	$LCTL set_param -n llite.*.read_ahead_stats=clear
+	dd if=$file of=/dev/null bs=4k ||
+		error "dd from $file failed"
+
+	async=$($LCTL get_param -n llite.*.read_ahead_stats |
+		get_named_value 'async readahead' | cut -d" " -f1 | calc_total)
+	$LCTL set_param -n \
+		llite.*.read_ahead_async_file_threshold_mb=$old_threshold
+	rm -f $file
+
+	(( async > 0 )) || error "no async readahead was done"
+}
+run_test 101h "sequential read uses async readahead"
+
 setup_test102() {
 	test_mkdir $DIR/$tdir
 	chown $RUNAS_ID $DIR/$tdir
@@ -8756,7 +8827,7 @@ test_115() {
 	[ $PARALLEL == "yes" ] && skip "skip parallel run"
 	remote_ost_nodsh && skip "remote OST with nodsh"
 
-	# Lustre does not stop service threads once they are started.
+	# Idle service threads only exit after threads_idle_timeout.
 	# Reset number of running threads to default.
 	stopall
 	setupall
@@ -8856,6 +8927,42 @@ test_115() {
 }
 run_test 115 "verify dynamic thread creation===================="
 
+test_115b() {
+	[ $PARALLEL == "yes" ] && skip "skip parallel run"
+	remote_ost_nodsh && skip "remote OST with nodsh"
+	do_facet ost1 "$LCTL get_param -n ost.OSS.ost_io.threads_idle_timeout" ||
+		skip "no threads_idle_timeout on OSS"
+
+	local save_params="$TMP/sanity-$TESTNAME.parameters"
+	local threads_min=$(do_facet ost1 \
+		"$LCTL get_param -n ost.OSS.ost_io.threads_min")
+	local threads
+
+	save_lustre_params ost1 "ost.OSS.ost_io.threads_idle_timeout" \
+		> $save_params
+	stack_trap "restore_lustre_params < $save_params; rm -f $save_params" \
+		EXIT
+
+	# make sure some threads above threads_min are running
+	test_mkdir $DIR/$tdir
+	$LFS setstripe -c 1 -i 0 $DIR/$tdir
+	for i in $(seq 16); do
+		dd if=/dev/zero of=$DIR/$tdir/$tfile-$i bs=1M count=16 \
+			oflag=direct &
+	done
+	wait
+	threads=$(do_facet ost1 \
+		"$LCTL get_param -n ost.OSS.ost_io.threads_started")
+	echo "threads_started $threads, threads_min $threads_min"
+
+	# setting the timeout wakes the threads waiting with the old one
+	do_facet ost1 "$LCTL set_param ost.OSS.ost_io.threads_idle_timeout=1"
+	wait_update_facet ost1 "$LCTL get_param -n \
+		ost.OSS.ost_io.threads_started" $threads_min 30 ||
+		error "idle threads did not exit"
+}
+run_test 115b "idle service threads exit ======================="
+
 free_min_max () {
 	wait_delete_completed
 	AVAIL=($(lctl get_param -n osc.*[oO][sS][cC]-[^M]*.kbytesavail))
@@ -9466,6 +9573,55 @@ test_118n()
 }
 run_test 118n "statfs() sends OST_STATFS requests in parallel"
 
+test_118o() {
+	local osc=$($LCTL dl | awk '/-osc-[^mM]/ && /OST0000/ { print $4 }')
+	local max=$($LCTL get_param -n osc.$osc.max_rpcs_in_flight)
+	local window
+	local rtt
+
+	[ -n "$osc" ] || skip "no OST0000 osc device"
+	$LCTL get_param osc.$osc.adaptive_rpcs_in_flight ||
+		skip "no adaptive RPC window support"
+
+	stack_trap "$LCTL set_param osc.$osc.adaptive_rpcs_in_flight=0" EXIT
+	$LCTL set_param osc.$osc.adaptive_rpcs_in_flight=1
+
+	$SETSTRIPE -i 0 -c 1 $DIR/$tfile || error "setstripe failed"
+	dd if=/dev/zero of=$DIR/$tfile bs=1M count=64 conv=fsync ||
+		error "dd failed"
+
+	$LCTL get_param osc.$osc.rpc_window
+	window=$($LCTL get_param -n osc.$osc.rpc_window |
+		 awk '/^window:/ { print $2 }')
+	rtt=$($LCTL get_param -n osc.$osc.rpc_window |
+	      awk '/^rtt_avg_us:/ { print $2 }')
+	(( window >= 1 && window <= max )) ||
+		error "window $window not in [1, $max]"
+	(( rtt > 0 )) || error "no RPC round trip time measured"
+}
+run_test 118o "adaptive RPC window stays within max_rpcs_in_flight"
+
+test_118p() {
+	local osc=$($LCTL dl | awk '/-osc-[^mM]/ && /OST0000/ { print $4 }')
+	local param=/sys/module/osc/parameters/osc_dirty_balance
+	local bw
+
+	[ -n "$osc" ] || skip "no OST0000 osc device"
+	[ -w $param ] || skip "no osc_dirty_balance parameter"
+
+	stack_trap "echo $(cat $param) > $param" EXIT
+	echo 1 > $param
+
+	$SETSTRIPE -i 0 -c 1 $DIR/$tfile || error "setstripe failed"
+	dd if=/dev/zero of=$DIR/$tfile bs=1M count=256 conv=fsync ||
+		error "dd failed"
+
+	bw=$($LCTL get_param -n osc.$osc.write_bandwidth_kbps)
+	echo "OST0000 write bandwidth: $bw KiB/s"
+	(( bw > 0 )) || error "no write bandwidth measured"
+}
+run_test 118p "dirty cache budget measures OSC write bandwidth"
+
 test_119a() # bug 11737
 {
         BSIZE=$((512 * 1024))
@@ -9531,6 +9687,27 @@ test_119d() # bug 15950
 }
 run_test 119d "The DIO path should try to send a new rpc once one is completed"
 
+test_119e() {
+	[[ $OSTCOUNT -lt 2 ]] && skip_env "needs >= 2 OSTs"
+
+	local stripe_size=$((1024 * 1024))
+
+	$SETSTRIPE -c 2 -S $stripe_size $DIR/$tfile ||
+		error "setstripe failed"
+	dd if=/dev/urandom of=$TMP/$tfile bs=$stripe_size count=8 ||
+		error "dd to $TMP/$tfile failed"
+	# a single O_DIRECT write and read spanning all stripes
+	dd if=$TMP/$tfile of=$DIR/$tfile bs=$((8 * stripe_size)) count=1 \
+		oflag=direct || error "direct write failed"
+	cancel_lru_locks osc
+	dd if=$DIR/$tfile of=$TMP/$tfile.2 bs=$((8 * stripe_size)) count=1 \
+		iflag=direct || error "direct read failed"
+	cmp $TMP/$tfile $TMP/$tfile.2 || error "data mismatch"
+	cmp $TMP/$tfile $DIR/$tfile || error "buffered read mismatch"
+	rm -f $DIR/$tfile $TMP/$tfile $TMP/$tfile.2
+}
+run_test 119e "DIO spanning several stripes"
+
 test_120a() {
 	[ $PARALLEL == "yes" ] && skip "skip parallel run"
 	remote_mds_nodsh && skip "remote MDS with nodsh"
@@ -10115,6 +10292,85 @@ test_124c() {
 }
 run_test 124c "LRUR cancel very aged locks"
 
+test_124d() {
+	local nsdir="ldlm.namespaces.*-MDT0000-mdc-*"
+	local nr=100
+
+	$LCTL get_param -n $nsdir.lock_memory_kb > /dev/null 2>&1 ||
+		skip "no lock_memory_kb accounting"
+
+	cancel_lru_locks mdc
+	local before=$($LCTL get_param -n $nsdir.lock_memory_kb)
+
+	test_mkdir $DIR/$tdir
+	createmany -o $DIR/$tdir/f $nr ||
+		error "failed to create $nr files in $DIR/$tdir"
+	ls -l $DIR/$tdir > /dev/null
+
+	local locks=$($LCTL get_param -n $nsdir.lock_count)
+	local after=$($LCTL get_param -n $nsdir.lock_memory_kb)
+	echo "$locks locks, lock memory ${before}KB -> ${after}KB"
+	[ $after -gt $before ] ||
+		error "lock memory did not grow with $locks locks"
+
+	cancel_lru_locks mdc
+	local freed=$($LCTL get_param -n $nsdir.lock_memory_kb)
+	[ $freed -lt $after ] ||
+		error "lock memory ${freed}KB not released after cancel"
+	unlinkmany $DIR/$tdir/f $nr
+}
+run_test 124d "namespace lock memory accounting"
+
+test_124e() {
+	[ $PARALLEL == "yes" ] && skip "skip parallel run"
+	which taskset > /dev/null 2>&1 || skip_env "no taskset command"
+
+	local nsdir="ldlm.namespaces.*-MDT0000-mdc-*"
+	local ncpus=$(getconf _NPROCESSORS_ONLN)
+	local nr=$((400 / ncpus + 1))
+	local cpu
+
+	cancel_lru_locks mdc
+	test_mkdir $DIR/$tdir
+	# cache unused locks from every CPU, so they are in all LRU parts
+	for ((cpu = 0; cpu < ncpus; cpu++)); do
+		taskset -c $cpu createmany -o $DIR/$tdir/f$cpu- $nr > /dev/null ||
+			error "failed to create files on CPU $cpu"
+	done
+
+	local unused=$($LCTL get_param -n $nsdir.lock_unused_count)
+	local limit=$((unused / 4))
+	local remaining
+
+	echo "$unused unused locks from $ncpus CPUs, lru_size=$limit"
+	stack_trap "lru_resize_enable mdc" EXIT
+	$LCTL set_param $nsdir.lru_size=$limit
+	remaining=$($LCTL get_param -n $nsdir.lock_unused_count)
+	[ $remaining -le $limit ] ||
+		error "$remaining unused locks, more than lru_size $limit"
+
+	$LCTL set_param $nsdir.lru_size=clear
+	remaining=$($LCTL get_param -n $nsdir.lock_unused_count)
+	[ $remaining -eq 0 ] || error "$remaining locks are not canceled"
+}
+run_test 124e "LRU cancel with locks cached from all CPUs"
+
+test_124e() {
+	local module=$LUSTRE/tests/kernel/kldlm_res.ko
+	local run_id=$RANDOM
+
+	[ -f $module ] || skip "no $module"
+
+	# The module runs the benchmark from its init and always fails
+	# to load, the results are reported in dmesg.
+	insmod $module run_id=$run_id &> /dev/null
+
+	dmesg | grep "lustre_kldlm_res_$run_id:"
+	dmesg | grep -q "lustre_kldlm_res_$run_id: done" ||
+		error "resource lookup benchmark failed"
+}
+run_test 124e "ldlm resource lookup benchmark (1, 16, 64 threads)"
+
 test_125() { # 13358
 	$LCTL get_param -n llite.*.client_type | grep -q local ||
 		skip "must run as local client"
@@ -10219,6 +10475,10 @@ test_127b() { # bug LU-333
 			[ $sum -ne $((PAGE_SIZE * 2)) ] &&
 				error "sum is wrong: $sum"
 			;;
+		range_lock_hold)
+			# only the writes take the range lock
+			[ $count -ne 2 ] && error "count is not 2: $count"
+			;;
 		*) ;;
 		esac
 	done < $TMP/$tfile.tmp
@@ -10226,6 +10486,7 @@ test_127b() { # bug LU-333
 	#check that we actually got some stats
 	[ "$read_bytes" ] || error "Missing read_bytes stats"
 	[ "$write_bytes" ] || error "Missing write_bytes stats"
+	[ "$range_lock_hold" ] || error "Missing range_lock_hold stats"
 	[ "$read_bytes" != 0 ] || error "no read done"
 	[ "$write_bytes" != 0 ] || error "no write done"
 
@@ -11162,6 +11423,34 @@ test_133h() {
 }
 run_test 133h "Proc files should end with newlines"
 
+test_133i() {
+	remote_ost_nodsh && skip "remote OST with nodsh"
+	$LCTL list_param osc.$FSNAME-OST0000*.rpc_latency ||
+		skip "no RPC latency histograms"
+
+	$LFS setstripe -c 1 -i 0 $DIR/$tfile || error "setstripe failed"
+	# collection is off by default, any write but 0 enables and clears it
+	$LCTL get_param -n osc.$FSNAME-OST0000*.rpc_latency |
+		grep -q "^disabled" || error "RPC latency enabled by default"
+	stack_trap "$LCTL set_param -n osc.$FSNAME-OST0000*.rpc_latency=0" EXIT
+	stack_trap "do_facet ost1 $LCTL set_param -n \
+		ost.OSS.ost_io.rpc_latency=0" EXIT
+	$LCTL set_param -n osc.$FSNAME-OST0000*.rpc_latency=1
+	do_facet ost1 $LCTL set_param -n ost.OSS.ost_io.rpc_latency=1
+
+	dd if=/dev/zero of=$DIR/$tfile bs=1M count=4 oflag=direct ||
+		error "dd failed"
+
+	$LCTL get_param osc.$FSNAME-OST0000*.rpc_latency
+	$LCTL get_param -n osc.$FSNAME-OST0000*.rpc_latency |
+		grep -q "^opcode: ost_write" ||
+		error "no client ost_write latency histogram"
+	do_facet ost1 $LCTL get_param -n ost.OSS.ost_io.rpc_latency |
+		grep -q "^opcode: ost_write" ||
+		error "no server ost_write latency histogram"
+}
+run_test 133i "Verifying RPC latency histograms"
+
 test_134a() {
 	remote_mds_nodsh && skip "remote MDS with nodsh"
 	[[ $(lustre_version_code $SINGLEMDS) -lt $(version_code 2.7.54) ]] &&
@@ -3831,6 +3831,76 @@ test_77n() { #LU-10802
 }
 run_test 77n "check wildcard support for TBF JobID NRS policy"
 
+test_77o() {
+	local oss=$(comma_list $(osts_nodes))
+	local saved_jobid_var=$($LCTL get_param -n jobid_var)
+	local dispatched
+
+	do_nodes $oss lctl set_param ost.OSS.ost_io.nrs_policies=deadline ||
+		skip "no NRS deadline policy"
+	if [ $saved_jobid_var != procname_uid ]; then
+		set_persistent_param_and_check client \
+			"jobid_var" "$FSNAME.sys.jobid_var" procname_uid
+		stack_trap "set_persistent_param_and_check client \
+			jobid_var $FSNAME.sys.jobid_var $saved_jobid_var" EXIT
+	fi
+	stack_trap "do_nodes $oss lctl set_param \
+		ost.OSS.ost_io.nrs_policies=fifo" EXIT
+
+	do_nodes $oss lctl set_param ost.OSS.ost_io.nrs_deadline_boost=60 \
+		ost.OSS.ost_io.nrs_deadline_jobids="dd.*" ||
+		error "failed to configure deadline policy"
+
+	nrs_write_read
+
+	do_facet ost1 lctl get_param ost.OSS.ost_io.nrs_deadline_stats
+	dispatched=$(do_facet ost1 lctl get_param -n \
+		     ost.OSS.ost_io.nrs_deadline_stats |
+		     awk '/^reg_interactive:/ { print $4 }' | tr -d ,)
+	(( dispatched > 0 )) || error "no interactive request was handled"
+}
+run_test 77o "check NRS deadline policy"
+
+test_77p() {
+	local oss=$(comma_list $(osts_nodes))
+	local rc=0
+
+	do_nodes $oss lctl set_param ost.OSS.ost_io.nrs_policies="tbf\ nid" ||
+		rc=$?
+	[[ $rc -eq 3 ]] && skip "no NRS TBF exists"
+	[[ $rc -ne 0 ]] && error "failed to set TBF NID policy"
+	stack_trap "do_nodes $oss lctl set_param \
+		ost.OSS.ost_io.nrs_policies=fifo" EXIT
+
+	# borrowing is only allowed when a rule is started
+	do_facet ost1 lctl set_param \
+		ost.OSS.ost_io.nrs_tbf_rule="change\ default\ borrow=1" &&
+		error "borrow should not be changeable"
+
+	tbf_rule_operate ost1 "start\ lo\ nid={0@lo}\ rate=10\ borrow=1"
+	local address=$(comma_list "$(host_nids_address $CLIENTS $NETTYPE)")
+	local client_nids=$(nids_list $address "\\")
+	tbf_rule_operate ost1 "start\ clients\ nid={$client_nids}\ rate=10\ borrow=1"
+
+	# with spare capacity the I/O must not be held to 10 RPC/s per CPT
+	local np=$(check_cpt_number ost1)
+	local dir=$DIR/$tdir
+
+	mkdir $dir || error "mkdir $dir failed"
+	$LFS setstripe -c 1 -i 0 $dir || error "setstripe to $dir failed"
+	local start=$SECONDS
+	dd if=/dev/zero of=$dir/tbf bs=1M count=100 oflag=direct ||
+		error "dd to $dir/tbf failed"
+	local runtime=$((SECONDS - start + 1))
+	echo "Write runtime is $runtime s with $np partitions"
+	(( runtime * np * 10 < 100 * 2 )) ||
+		error "borrowing rules were throttled to their rate ($runtime s)"
+
+	tbf_rule_operate ost1 "stop\ clients"
+	tbf_rule_operate ost1 "stop\ lo"
+}
+run_test 77p "check TBF rules borrowing spare capacity"
+
 test_78() { #LU-6673
 	local rc
 
@@ -4483,6 +4553,82 @@ test_102() {
 }
 run_test 102 "Test open by handle of unlinked file"
 
+test_103() {
+	$LCTL get_param -n osc.*.connect_flags | grep -q bl_ast_batch ||
+		skip "server does not support batched blocking AST"
+
+	local nlocks=16
+	local lcount
+	local blk1
+	local blk2
+	local i
+
+	$LFS setstripe -c 1 -i 0 $DIR1/$tfile || error "setstripe failed"
+	dd if=/dev/zero of=$DIR1/$tfile bs=1M count=1 || error "dd failed"
+	cancel_lru_locks osc
+
+	# lockahead locks are not expanded, so mount1 ends up with
+	# $nlocks separate extent locks on the same object
+	for ((i = 0; i < nlocks; i++)); do
+		$LFS ladvise -a lockahead -m WRITE -s $((i * 2))M \
+			-e $((i * 2 + 1))M $DIR1/$tfile ||
+			error "lockahead $i failed"
+	done
+	sleep 1
+	lcount=$($LCTL get_param -n \
+		 ldlm.namespaces.*-OST0000-osc-*.lock_count | calc_sum)
+	(( lcount >= nlocks )) || skip "only $lcount locks granted"
+
+	blk1=$($LCTL get_param -n ldlm.services.ldlm_cbd.stats |
+	       awk '/ldlm_bl_callback/ {print $2}')
+	$TRUNCATE $DIR2/$tfile 0 || error "truncate failed"
+	blk2=$($LCTL get_param -n ldlm.services.ldlm_cbd.stats |
+	       awk '/ldlm_bl_callback/ {print $2}')
+	echo "$((blk2 - blk1)) blocking AST RPCs for $lcount locks"
+	(( blk2 - blk1 < nlocks )) ||
+		error "$((blk2 - blk1)) blocking AST RPCs, not batched"
+	$CHECKSTAT -s 0 $DIR1/$tfile || error "wrong size after truncate"
+}
+run_test 103 "blocking ASTs for one client are batched"
+
+test_104() {
+	local param="ldlm.namespaces.filter-*.expand_history"
+	local old=$(do_facet ost1 $LCTL get_param -n $param | head -n 1)
+	local dirs=($DIR1 $DIR2)
+	local blk1
+	local blk2
+	local i
+
+	[ -n "$old" ] || skip "server does not support expand_history"
+
+	do_facet ost1 $LCTL set_param -n $param=1
+	stack_trap "do_facet ost1 $LCTL set_param -n $param=$old" EXIT
+
+	$LFS setstripe -c 1 -i 0 $DIR1/$tfile || error "setstripe failed"
+
+	# strided writes, mounts write alternate 1MB chunks
+	for ((i = 0; i < 4; i++)); do
+		dd if=/dev/zero of=${dirs[i % 2]}/$tfile bs=1M seek=$i \
+			count=1 conv=notrunc 2> /dev/null ||
+			error "dd $i failed"
+	done
+
+	blk1=$($LCTL get_param -n ldlm.services.ldlm_cbd.stats |
+	       awk '/ldlm_bl_callback/ {print $2}')
+	for ((i = 4; i < 20; i++)); do
+		dd if=/dev/zero of=${dirs[i % 2]}/$tfile bs=1M seek=$i \
+			count=1 conv=notrunc 2> /dev/null ||
+			error "dd $i failed"
+	done
+	blk2=$($LCTL get_param -n ldlm.services.ldlm_cbd.stats |
+	       awk '/ldlm_bl_callback/ {print $2}')
+
+	echo "$((blk2 - blk1)) blocking ASTs for 16 strided writes"
+	(( blk2 - blk1 <= 4 )) ||
+		error "$((blk2 - blk1)) blocking ASTs, locks still ping-pong"
+}
+run_test 104 "extent locks are not over-expanded for strided writers"
+
 log "cleanup: ======================================================"
 
 # kill and wait in each test only guarentee script finish, but command in script
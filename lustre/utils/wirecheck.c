@@ -604,6 +604,7 @@ check_obd_connect_data(void)
 	CHECK_DEFINE_64X(OBD_CONNECT2_WBC_INTENTS);
 	CHECK_DEFINE_64X(OBD_CONNECT2_LOCK_CONVERT);
 	CHECK_DEFINE_64X(OBD_CONNECT2_ARCHIVE_ID_ARRAY);
+	CHECK_DEFINE_64X(OBD_CONNECT2_BL_AST_BATCH);
 
 	CHECK_VALUE_X(OBD_CKSUM_CRC32);
 	CHECK_VALUE_X(OBD_CKSUM_ADLER);